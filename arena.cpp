@@ -0,0 +1,125 @@
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+
+// Monotonic bump allocator. Individual allocations are never freed: reset()
+// reclaims everything at once, keeping the first block for reuse, and the
+// destructor returns all blocks. Destructors of objects placed here are not
+// run by the arena itself; use ArenaDelete or AllocateShared for that.
+class Arena {
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+    };
+
+    Block* head;
+    char* cur;
+    char* end;
+    size_t block_size;
+    size_t used_bytes;
+
+    void add_block(size_t min_size) {
+        size_t size = std::max(block_size, min_size + sizeof(Block));
+        Block* b = static_cast<Block*>(::operator new(size));
+        b->next = head;
+        b->size = size;
+        head = b;
+        cur = reinterpret_cast<char*>(b + 1);
+        end = reinterpret_cast<char*>(b) + size;
+    }
+
+    void free_blocks(Block* b) {
+        while (b != nullptr) {
+            Block* next = b->next;
+            ::operator delete(b);
+            b = next;
+        }
+    }
+
+public:
+    explicit Arena(size_t bs = 64 * 1024)
+        : head(nullptr), cur(nullptr), end(nullptr), block_size(bs), used_bytes(0) { }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() {
+        free_blocks(head);
+    }
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        void* p = cur;
+        size_t space = end - cur;
+        if (head == nullptr || std::align(align, size, p, space) == nullptr) {
+            add_block(size + align);
+            p = cur;
+            space = end - cur;
+            std::align(align, size, p, space);
+        }
+        cur = static_cast<char*>(p) + size;
+        used_bytes += size;
+        return p;
+    }
+
+    template<typename T, typename... Args>
+    T* create(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    T* create_array(size_t n) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena arrays are never destroyed");
+        T* p = static_cast<T*>(allocate(sizeof(T) * n, alignof(T)));
+        std::uninitialized_default_construct_n(p, n);
+        return p;
+    }
+
+    void reset() {
+        if (head == nullptr)
+            return;
+        Block* last = head;
+        Block* rest = nullptr;
+        while (last->next != nullptr) {
+            Block* next = last->next;
+            last->next = rest;
+            rest = last;
+            last = next;
+        }
+        free_blocks(rest);
+        head = last;
+        cur = reinterpret_cast<char*>(last + 1);
+        end = reinterpret_cast<char*>(last) + last->size;
+        used_bytes = 0;
+    }
+
+    size_t used() const noexcept {
+        return used_bytes;
+    }
+};
+
+inline Arena& ThreadArena() {
+    thread_local Arena arena;
+    return arena;
+}
+
+// Deleter for UniquePtr over arena-placed objects: runs the destructor only,
+// the memory goes back with the arena.
+template<typename T>
+class ArenaDelete {
+public:
+    void operator()(T* p) const noexcept {
+        p->~T();
+    }
+};
+
+template<typename T>
+class ArenaDelete<T[]> {
+public:
+    static_assert(std::is_trivially_destructible<T>::value, "arena arrays are never destroyed");
+
+    void operator()(T*) const noexcept { }
+};
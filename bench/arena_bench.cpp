@@ -0,0 +1,78 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+#include "arena.cpp"
+#include "shared_ptr.cpp"
+#include "unique_ptr.cpp"
+
+struct Node {
+    long key;
+    double value;
+    std::string tag;
+
+    Node(long k) : key(k), value(k * 0.5), tag("node") { }
+};
+
+static void BM_RequestUniqueDefault(benchmark::State& state) {
+    size_t n = state.range(0);
+    for (auto _ : state) {
+        std::vector<UniquePtr<Node>> v;
+        v.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            v.emplace_back(new Node(i));
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void BM_RequestUniqueArena(benchmark::State& state) {
+    size_t n = state.range(0);
+    Arena arena;
+    for (auto _ : state) {
+        {
+            std::vector<UniquePtr<Node, ArenaDelete<Node>>> v;
+            v.reserve(n);
+            for (size_t i = 0; i < n; ++i)
+                v.emplace_back(arena.create<Node>(i));
+            benchmark::DoNotOptimize(v.data());
+        }
+        arena.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void BM_RequestSharedDefault(benchmark::State& state) {
+    size_t n = state.range(0);
+    for (auto _ : state) {
+        std::vector<SharedPtr<Node>> v;
+        v.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            v.emplace_back(new Node(i));
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void BM_RequestSharedArena(benchmark::State& state) {
+    size_t n = state.range(0);
+    Arena& arena = ThreadArena();
+    for (auto _ : state) {
+        {
+            std::vector<SharedPtr<Node>> v;
+            v.reserve(n);
+            for (size_t i = 0; i < n; ++i)
+                v.push_back(AllocateShared<Node>(arena, i));
+            benchmark::DoNotOptimize(v.data());
+        }
+        arena.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(BM_RequestUniqueDefault)->Range(64, 16384);
+BENCHMARK(BM_RequestUniqueArena)->Range(64, 16384);
+BENCHMARK(BM_RequestSharedDefault)->Range(64, 16384);
+BENCHMARK(BM_RequestSharedArena)->Range(64, 16384);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "matrix_io.cpp"
+
+static Matrix<double> RandomMatrix(size_t n) {
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    Matrix<double> m(n, n);
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < n; ++j)
+            m(i, j) = dist(gen);
+    return m;
+}
+
+static void BM_MatrixWriteText(benchmark::State& state) {
+    Matrix<double> m = RandomMatrix(state.range(0));
+    for (auto _ : state) {
+        std::ostringstream out;
+        out << m;
+        benchmark::DoNotOptimize(out.str().size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+
+static void BM_MatrixParseText(benchmark::State& state) {
+    std::ostringstream out;
+    out << RandomMatrix(state.range(0));
+    std::string text = out.str();
+    for (auto _ : state) {
+        std::istringstream in(text);
+        Matrix<double> m = ParseMatrix<double>(in);
+        benchmark::DoNotOptimize(m.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+
+static void BM_MatrixWriteBinary(benchmark::State& state) {
+    Matrix<double> m = RandomMatrix(state.range(0));
+    for (auto _ : state) {
+        std::ostringstream out;
+        WriteMatrix(out, m);
+        benchmark::DoNotOptimize(out.str().size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+
+static void BM_MatrixReadBinary(benchmark::State& state) {
+    std::ostringstream out;
+    WriteMatrix(out, RandomMatrix(state.range(0)));
+    std::string bytes = out.str();
+    for (auto _ : state) {
+        std::istringstream in(bytes);
+        Matrix<double> m = ReadMatrix<double>(in);
+        benchmark::DoNotOptimize(m.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+
+static void BM_MatrixMap(benchmark::State& state) {
+    std::string path = "io_bench_" + std::to_string(state.range(0)) + ".bin";
+    {
+        std::ofstream out(path, std::ios::binary);
+        WriteMatrix(out, RandomMatrix(state.range(0)));
+    }
+    for (auto _ : state) {
+        Matrix<double> m = MapMatrix<double>(path);
+        benchmark::DoNotOptimize(m.size());
+    }
+    std::remove(path.c_str());
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+
+BENCHMARK(BM_MatrixWriteText)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_MatrixParseText)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_MatrixWriteBinary)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_MatrixReadBinary)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_MatrixMap)->RangeMultiplier(4)->Range(16, 1024);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "matrix_batch.cpp"
+
+static std::vector<Matrix<double>> RandomMatrices(size_t count, size_t rows, size_t cols, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<Matrix<double>> res;
+    res.reserve(count);
+    for (size_t b = 0; b < count; ++b) {
+        std::vector<std::vector<double>> v(rows, std::vector<double>(cols));
+        for (size_t i = 0; i < rows; ++i)
+            for (size_t j = 0; j < cols; ++j)
+                v[i][j] = dist(gen) + (i == j ? rows : 0);
+        res.emplace_back(v);
+    }
+    return res;
+}
+
+static void BM_LoopMultiply(benchmark::State& state) {
+    size_t count = state.range(0), n = state.range(1);
+    std::vector<Matrix<double>> a = RandomMatrices(count, n, n, 1), b = RandomMatrices(count, n, n, 2);
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i) {
+            Matrix<double> c = a[i] * b[i];
+            benchmark::DoNotOptimize(c(0, 0));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_BatchMultiply(benchmark::State& state) {
+    size_t count = state.range(0), n = state.range(1);
+    MatrixBatch<double> a(RandomMatrices(count, n, n, 1)), b(RandomMatrices(count, n, n, 2));
+    for (auto _ : state) {
+        MatrixBatch<double> c = a * b;
+        benchmark::DoNotOptimize(c(0, 0, 0));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_LoopSolve(benchmark::State& state) {
+    size_t count = state.range(0), n = state.range(1);
+    std::vector<Matrix<double>> a = RandomMatrices(count, n, n, 3);
+    std::vector<double> b(n, 1.0);
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i) {
+            std::vector<double> x = a[i].solve(b);
+            benchmark::DoNotOptimize(x.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_BatchSolve(benchmark::State& state) {
+    size_t count = state.range(0), n = state.range(1);
+    MatrixBatch<double> a(RandomMatrices(count, n, n, 3)), b(count, n, 1);
+    for (size_t i = 0; i < n; ++i)
+        for (size_t l = 0; l < count; ++l)
+            b(l, i, 0) = 1.0;
+    for (auto _ : state) {
+        MatrixBatch<double> x = a.solve(b);
+        benchmark::DoNotOptimize(x(0, 0, 0));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_BatchTranspose(benchmark::State& state) {
+    size_t count = state.range(0), n = state.range(1);
+    MatrixBatch<double> a(RandomMatrices(count, n, n, 4));
+    for (auto _ : state) {
+        a.transpose();
+        benchmark::DoNotOptimize(a(0, 0, 0));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+BENCHMARK(BM_LoopMultiply)->ArgsProduct({{1024, 65536}, {3, 4, 6}});
+BENCHMARK(BM_BatchMultiply)->ArgsProduct({{1024, 65536}, {3, 4, 6}});
+BENCHMARK(BM_LoopSolve)->ArgsProduct({{1024, 65536}, {3, 4, 6}});
+BENCHMARK(BM_BatchSolve)->ArgsProduct({{1024, 65536}, {3, 4, 6}});
+BENCHMARK(BM_BatchTranspose)->ArgsProduct({{1024, 65536}, {3, 4, 6}});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,217 @@
+#include <benchmark/benchmark.h>
+#include <array>
+#include <random>
+#include <vector>
+
+#include "matrix.cpp"
+#include "matrix_polynomial.cpp"
+#include "polynomial_dense.cpp"
+
+static Matrix<double> RandomMatrix(size_t rows, size_t cols, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<std::vector<double>> v(rows, std::vector<double>(cols));
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < cols; ++j)
+            v[i][j] = dist(gen);
+    return Matrix<double>(v);
+}
+
+static void BM_MatrixMultiply(benchmark::State& state) {
+    size_t n = state.range(0);
+    Matrix<double> a = RandomMatrix(n, n, 1), b = RandomMatrix(n, n, 2);
+    for (auto _ : state) {
+        Matrix<double> c = a * b;
+        benchmark::DoNotOptimize(c(0, 0));
+    }
+    state.SetItemsProcessed(state.iterations() * 2 * n * n * n);
+}
+
+static void BM_MatrixSolve(benchmark::State& state) {
+    size_t n = state.range(0);
+    Matrix<double> a = RandomMatrix(n, n, 3);
+    for (size_t i = 0; i < n; ++i)
+        a(i, i) += n;
+    std::vector<double> b(n, 1.0);
+    for (auto _ : state) {
+        std::vector<double> x = a.solve(b);
+        benchmark::DoNotOptimize(x.data());
+    }
+}
+
+// Factors in float and refines to double accuracy.
+static void BM_MatrixSolveRefined(benchmark::State& state) {
+    size_t n = state.range(0);
+    Matrix<double> a = RandomMatrix(n, n, 3);
+    for (size_t i = 0; i < n; ++i)
+        a(i, i) += n;
+    std::vector<double> b(n, 1.0);
+    for (auto _ : state) {
+        std::vector<double> x = a.solve_refined(b);
+        benchmark::DoNotOptimize(x.data());
+    }
+}
+
+static void BM_MatrixTranspose(benchmark::State& state) {
+    size_t n = state.range(0);
+    Matrix<double> a = RandomMatrix(n, n, 4);
+    for (auto _ : state) {
+        a.transpose();
+        benchmark::DoNotOptimize(a(0, 0));
+    }
+    state.SetBytesProcessed(state.iterations() * n * n * sizeof(double));
+}
+
+static void BM_MatrixAdd(benchmark::State& state) {
+    size_t n = state.range(0);
+    Matrix<double> a = RandomMatrix(n, n, 5), b = RandomMatrix(n, n, 6);
+    for (auto _ : state) {
+        a += b;
+        benchmark::DoNotOptimize(a(0, 0));
+    }
+    state.SetItemsProcessed(state.iterations() * n * n);
+}
+
+// Copies that are never written and sums of temporaries should not allocate
+// a fresh buffer for every intermediate.
+static void BM_MatrixSumChain(benchmark::State& state) {
+    size_t n = state.range(0);
+    Matrix<double> a = RandomMatrix(n, n, 8), b = RandomMatrix(n, n, 9);
+    for (auto _ : state) {
+        Matrix<double> copy = a;
+        Matrix<double> c = copy + b + a + b + 2.0 * a;
+        benchmark::DoNotOptimize(c.view().ptr());
+    }
+    state.SetItemsProcessed(state.iterations() * n * n);
+}
+
+// Adds the lower-right quadrant into the upper-left one in place.
+static void BM_MatrixBlockAdd(benchmark::State& state) {
+    size_t n = state.range(0), h = n / 2;
+    Matrix<double> a = RandomMatrix(n, n, 7);
+    for (auto _ : state) {
+        a.block(0, 0, h, h) += a.block(h, h, h, h);
+        benchmark::DoNotOptimize(a(0, 0));
+    }
+    state.SetItemsProcessed(state.iterations() * h * h);
+}
+
+template<size_t N>
+static Matrix<double, N, N> RandomFixed(unsigned seed) {
+    Matrix<double, N, N> res(RandomMatrix(N, N, seed));
+    for (size_t i = 0; i < N; ++i)
+        res(i, i) += N;
+    return res;
+}
+
+template<size_t N>
+static void BM_SmallDynamicMultiply(benchmark::State& state) {
+    Matrix<double> a = RandomFixed<N>(1).dynamic(), b = RandomFixed<N>(2).dynamic();
+    for (auto _ : state) {
+        a *= b;
+        benchmark::DoNotOptimize(a(0, 0));
+    }
+}
+
+template<size_t N>
+static void BM_SmallFixedMultiply(benchmark::State& state) {
+    Matrix<double, N, N> a = RandomFixed<N>(1), b = RandomFixed<N>(2);
+    for (auto _ : state) {
+        a *= b;
+        benchmark::DoNotOptimize(a(0, 0));
+    }
+}
+
+template<size_t N>
+static void BM_SmallDynamicSolve(benchmark::State& state) {
+    Matrix<double> a = RandomFixed<N>(3).dynamic();
+    std::vector<double> b(N, 1.0);
+    for (auto _ : state) {
+        std::vector<double> x = a.solve(b);
+        benchmark::DoNotOptimize(x.data());
+    }
+}
+
+template<size_t N>
+static void BM_SmallFixedSolve(benchmark::State& state) {
+    Matrix<double, N, N> a = RandomFixed<N>(3);
+    std::array<double, N> b;
+    b.fill(1.0);
+    for (auto _ : state) {
+        std::array<double, N> x = a.solve(b);
+        benchmark::DoNotOptimize(x.data());
+    }
+}
+
+template<size_t N>
+static void BM_SmallFixedInverse(benchmark::State& state) {
+    Matrix<double, N, N> a = RandomFixed<N>(4);
+    for (auto _ : state) {
+        Matrix<double, N, N> inv = a.inverse();
+        benchmark::DoNotOptimize(inv(0, 0));
+    }
+}
+
+// Degree-d polynomial of a 64 x 64 matrix: Horner's rule takes d products,
+// Paterson-Stockmeyer about 2 sqrt(d).
+static Polynomial<double> RandomPolynomial(size_t degree) {
+    std::mt19937 gen(10);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<double> c(degree + 1);
+    for (size_t i = 0; i < c.size(); ++i)
+        c[i] = dist(gen) / (i + 1);
+    return Polynomial<double>(c);
+}
+
+static void BM_MatrixPolynomialHorner(benchmark::State& state) {
+    size_t n = 64, d = state.range(0);
+    Matrix<double> a = RandomMatrix(n, n, 11);
+    Polynomial<double> p = RandomPolynomial(d);
+    for (auto _ : state) {
+        Matrix<double> r(n, n);
+        for (size_t i = d + 1; i-- > 0;) {
+            r *= a;
+            for (size_t k = 0; k < n; ++k)
+                r(k, k) += p[i];
+        }
+        benchmark::DoNotOptimize(r.view().ptr());
+    }
+}
+
+static void BM_MatrixPolynomial(benchmark::State& state) {
+    size_t n = 64, d = state.range(0);
+    Matrix<double> a = RandomMatrix(n, n, 11);
+    Polynomial<double> p = RandomPolynomial(d);
+    for (auto _ : state) {
+        Matrix<double> r = PolynomialOfMatrix(p, a);
+        benchmark::DoNotOptimize(r.view().ptr());
+    }
+}
+
+BENCHMARK(BM_MatrixMultiply)->RangeMultiplier(2)->Range(4, 256);
+BENCHMARK(BM_MatrixSolve)->RangeMultiplier(2)->Range(4, 512);
+BENCHMARK(BM_MatrixSolveRefined)->RangeMultiplier(2)->Range(4, 512);
+BENCHMARK(BM_MatrixTranspose)->RangeMultiplier(2)->Range(4, 1024);
+BENCHMARK(BM_MatrixAdd)->RangeMultiplier(2)->Range(4, 1024);
+BENCHMARK(BM_MatrixSumChain)->RangeMultiplier(4)->Range(4, 1024);
+BENCHMARK(BM_MatrixBlockAdd)->RangeMultiplier(2)->Range(4, 1024);
+BENCHMARK(BM_MatrixPolynomialHorner)->RangeMultiplier(4)->Range(4, 64);
+BENCHMARK(BM_MatrixPolynomial)->RangeMultiplier(4)->Range(4, 64);
+
+BENCHMARK_TEMPLATE(BM_SmallDynamicMultiply, 3);
+BENCHMARK_TEMPLATE(BM_SmallFixedMultiply, 3);
+BENCHMARK_TEMPLATE(BM_SmallDynamicMultiply, 4);
+BENCHMARK_TEMPLATE(BM_SmallFixedMultiply, 4);
+BENCHMARK_TEMPLATE(BM_SmallDynamicMultiply, 6);
+BENCHMARK_TEMPLATE(BM_SmallFixedMultiply, 6);
+BENCHMARK_TEMPLATE(BM_SmallDynamicSolve, 3);
+BENCHMARK_TEMPLATE(BM_SmallFixedSolve, 3);
+BENCHMARK_TEMPLATE(BM_SmallDynamicSolve, 4);
+BENCHMARK_TEMPLATE(BM_SmallFixedSolve, 4);
+BENCHMARK_TEMPLATE(BM_SmallDynamicSolve, 6);
+BENCHMARK_TEMPLATE(BM_SmallFixedSolve, 6);
+BENCHMARK_TEMPLATE(BM_SmallFixedInverse, 3);
+BENCHMARK_TEMPLATE(BM_SmallFixedInverse, 4);
+BENCHMARK_TEMPLATE(BM_SmallFixedInverse, 6);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "matrix.cpp"
+#include "polynomial_dense.cpp"
+#include "modint.cpp"
+#include "prime_field.cpp"
+
+// The same workloads over the naive PrimeField, which reduces with a 64-bit
+// division after every multiply, and over ModInt, whose overloads switch the
+// engines to Montgomery batch kernels.
+using Montgomery998 = ModInt<998244353>;
+
+template<typename F>
+static std::vector<F> RandomVector(size_t n, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::vector<F> v(n);
+    for (size_t i = 0; i < n; ++i)
+        v[i] = gen();
+    return v;
+}
+
+template<typename F>
+static Matrix<F> RandomMatrix(size_t n, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::vector<std::vector<F>> v(n, std::vector<F>(n));
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < n; ++j)
+            v[i][j] = gen();
+    return Matrix<F>(v);
+}
+
+template<typename F>
+static void BM_PolyMultiply(benchmark::State& state) {
+    size_t n = state.range(0);
+    Polynomial<F> a(RandomVector<F>(n, 1)), b(RandomVector<F>(n, 2));
+    for (auto _ : state) {
+        Polynomial<F> c = a * b;
+        benchmark::DoNotOptimize(c.Degree());
+    }
+    state.SetItemsProcessed(state.iterations() * n * n);
+}
+
+template<typename F>
+static void BM_PolyEvaluate(benchmark::State& state) {
+    size_t n = state.range(0);
+    Polynomial<F> a(RandomVector<F>(n, 3));
+    F x = 12345;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a(x));
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+template<typename F>
+static void BM_PolyDivide(benchmark::State& state) {
+    size_t n = state.range(0);
+    Polynomial<F> a(RandomVector<F>(2 * n, 4)), b(RandomVector<F>(n, 5));
+    for (auto _ : state) {
+        Polynomial<F> c = a / b;
+        benchmark::DoNotOptimize(c.Degree());
+    }
+}
+
+template<typename F>
+static void BM_MatMultiply(benchmark::State& state) {
+    size_t n = state.range(0);
+    Matrix<F> a = RandomMatrix<F>(n, 6), b = RandomMatrix<F>(n, 7);
+    for (auto _ : state) {
+        Matrix<F> c = a * b;
+        benchmark::DoNotOptimize(c(0, 0));
+    }
+    state.SetItemsProcessed(state.iterations() * n * n * n);
+}
+
+template<typename F>
+static void BM_MatSolve(benchmark::State& state) {
+    size_t n = state.range(0);
+    Matrix<F> a = RandomMatrix<F>(n, 8);
+    std::vector<F> b = RandomVector<F>(n, 9);
+    for (auto _ : state) {
+        std::vector<F> x = a.solve(b);
+        benchmark::DoNotOptimize(x.data());
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_PolyMultiply, PrimeField)->RangeMultiplier(4)->Range(64, 4096);
+BENCHMARK_TEMPLATE(BM_PolyMultiply, Montgomery998)->RangeMultiplier(4)->Range(64, 4096);
+BENCHMARK_TEMPLATE(BM_PolyEvaluate, PrimeField)->RangeMultiplier(16)->Range(64, 65536);
+BENCHMARK_TEMPLATE(BM_PolyEvaluate, Montgomery998)->RangeMultiplier(16)->Range(64, 65536);
+BENCHMARK_TEMPLATE(BM_PolyDivide, PrimeField)->RangeMultiplier(4)->Range(16, 256);
+BENCHMARK_TEMPLATE(BM_PolyDivide, Montgomery998)->RangeMultiplier(4)->Range(16, 256);
+BENCHMARK_TEMPLATE(BM_MatMultiply, PrimeField)->RangeMultiplier(4)->Range(16, 256);
+BENCHMARK_TEMPLATE(BM_MatMultiply, Montgomery998)->RangeMultiplier(4)->Range(16, 256);
+BENCHMARK_TEMPLATE(BM_MatSolve, PrimeField)->RangeMultiplier(4)->Range(16, 256);
+BENCHMARK_TEMPLATE(BM_MatSolve, Montgomery998)->RangeMultiplier(4)->Range(16, 256);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "polynomial_dense.cpp"
+#include "prime_field.cpp"
+
+using Poly = Polynomial<PrimeField>;
+
+static Poly RandomPoly(size_t degree, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::vector<PrimeField> v(degree + 1);
+    for (size_t i = 0; i < v.size(); ++i)
+        v[i] = gen();
+    v.back() = 1;
+    return Poly(v);
+}
+
+static void BM_DenseMultiply(benchmark::State& state) {
+    Poly a = RandomPoly(state.range(0), 1), b = RandomPoly(state.range(0), 2);
+    for (auto _ : state) {
+        Poly c = a * b;
+        benchmark::DoNotOptimize(c.Degree());
+    }
+    state.SetComplexityN(state.range(0));
+}
+
+static void BM_DenseDivide(benchmark::State& state) {
+    Poly a = RandomPoly(2 * state.range(0), 3), b = RandomPoly(state.range(0), 4);
+    for (auto _ : state) {
+        Poly c = a / b;
+        benchmark::DoNotOptimize(c.Degree());
+    }
+    state.SetComplexityN(state.range(0));
+}
+
+static void BM_DenseGcd(benchmark::State& state) {
+    Poly g = RandomPoly(state.range(0) / 2, 5);
+    Poly a = g * RandomPoly(state.range(0) / 2, 6), b = g * RandomPoly(state.range(0) / 2, 7);
+    for (auto _ : state) {
+        Poly c = (a, b);
+        benchmark::DoNotOptimize(c.Degree());
+    }
+    state.SetComplexityN(state.range(0));
+}
+
+static void BM_DenseEvaluate(benchmark::State& state) {
+    Poly a = RandomPoly(state.range(0), 8);
+    PrimeField x = 12345;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a(x));
+    state.SetComplexityN(state.range(0));
+}
+
+// Raising to the n-th power by repeated squaring against pow().
+static void BM_DensePowSquaring(benchmark::State& state) {
+    Poly a = RandomPoly(16, 9);
+    for (auto _ : state) {
+        Poly r(PrimeField(1)), cur = a;
+        for (size_t e = state.range(0); e; e >>= 1) {
+            if (e & 1)
+                r *= cur;
+            if (e > 1)
+                cur *= cur;
+        }
+        benchmark::DoNotOptimize(r.Degree());
+    }
+}
+
+static void BM_DensePow(benchmark::State& state) {
+    Poly a = RandomPoly(16, 9);
+    for (auto _ : state) {
+        Poly r = a.pow(state.range(0));
+        benchmark::DoNotOptimize(r.Degree());
+    }
+}
+
+BENCHMARK(BM_DenseMultiply)->RangeMultiplier(4)->Range(16, 1024)->Complexity();
+BENCHMARK(BM_DenseDivide)->RangeMultiplier(4)->Range(16, 256)->Complexity();
+BENCHMARK(BM_DenseGcd)->RangeMultiplier(4)->Range(16, 64)->Complexity();
+BENCHMARK(BM_DensePowSquaring)->RangeMultiplier(4)->Range(4, 256);
+BENCHMARK(BM_DensePow)->RangeMultiplier(4)->Range(4, 256);
+BENCHMARK(BM_DenseEvaluate)->RangeMultiplier(4)->Range(16, 65536)->Complexity();
+
+BENCHMARK_MAIN();
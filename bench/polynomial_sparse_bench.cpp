@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+#include <map>
+
+#include "polynomial_sparse.cpp"
+#include "prime_field.cpp"
+
+using Poly = Polynomial<PrimeField>;
+
+// Degree `degree` with roughly `density` percent of the coefficients nonzero.
+static Poly RandomPoly(size_t degree, int density, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::vector<PrimeField> v(degree + 1);
+    for (size_t i = 0; i < v.size(); ++i)
+        if (static_cast<int>(gen() % 100) < density)
+            v[i] = gen();
+    v.back() = 1;
+    return Poly(v);
+}
+
+static void BM_SparseMultiply(benchmark::State& state) {
+    Poly a = RandomPoly(state.range(0), state.range(1), 1);
+    Poly b = RandomPoly(state.range(0), state.range(1), 2);
+    for (auto _ : state) {
+        Poly c = a * b;
+        benchmark::DoNotOptimize(c.Degree());
+    }
+}
+
+static void BM_SparseDivide(benchmark::State& state) {
+    Poly a = RandomPoly(2 * state.range(0), state.range(1), 3);
+    Poly b = RandomPoly(state.range(0), state.range(1), 4);
+    for (auto _ : state) {
+        Poly c = a / b;
+        benchmark::DoNotOptimize(c.Degree());
+    }
+}
+
+static void BM_SparseGcd(benchmark::State& state) {
+    Poly g = RandomPoly(state.range(0) / 2, state.range(1), 5);
+    Poly a = g * RandomPoly(state.range(0) / 2, state.range(1), 6);
+    Poly b = g * RandomPoly(state.range(0) / 2, state.range(1), 7);
+    for (auto _ : state) {
+        Poly c = (a, b);
+        benchmark::DoNotOptimize(c.Degree());
+    }
+}
+
+static void BM_SparseEvaluate(benchmark::State& state) {
+    Poly a = RandomPoly(state.range(0), state.range(1), 8);
+    PrimeField x = 12345;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a(x));
+}
+
+// (1 + 3x^5 + x^40)^n by repeated squaring against pow().
+static void BM_SparsePowSquaring(benchmark::State& state) {
+    Poly a(std::map<size_t, PrimeField>{{0, 1}, {5, 3}, {40, 1}});
+    for (auto _ : state) {
+        Poly r(PrimeField(1)), cur = a;
+        for (size_t e = state.range(0); e; e >>= 1) {
+            if (e & 1)
+                r *= cur;
+            if (e > 1)
+                cur *= cur;
+        }
+        benchmark::DoNotOptimize(r.Degree());
+    }
+}
+
+static void BM_SparsePow(benchmark::State& state) {
+    Poly a(std::map<size_t, PrimeField>{{0, 1}, {5, 3}, {40, 1}});
+    for (auto _ : state) {
+        Poly r = a.pow(state.range(0));
+        benchmark::DoNotOptimize(r.Degree());
+    }
+}
+
+BENCHMARK(BM_SparseMultiply)->ArgsProduct({{16, 128, 1024}, {1, 10, 100}});
+BENCHMARK(BM_SparseDivide)->ArgsProduct({{16, 64, 256}, {1, 10, 100}});
+BENCHMARK(BM_SparseGcd)->ArgsProduct({{16, 32, 64}, {10, 100}});
+BENCHMARK(BM_SparsePowSquaring)->RangeMultiplier(4)->Range(4, 64);
+BENCHMARK(BM_SparsePow)->RangeMultiplier(4)->Range(4, 64);
+BENCHMARK(BM_SparseEvaluate)->ArgsProduct({{16, 1024, 65536}, {1, 10, 100}});
+
+BENCHMARK_MAIN();
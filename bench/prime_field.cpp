@@ -0,0 +1,84 @@
+#include <cstdint>
+
+#include "field.cpp"
+
+// Plain modular coefficient type for the polynomial benchmarks: division,
+// remainder and GCD need exact arithmetic, which doubles do not provide.
+class PrimeField {
+private:
+    static const uint32_t P = 998244353;
+    uint32_t v;
+
+public:
+    PrimeField(long long x = 0) : v(static_cast<uint32_t>((x % P + P) % P)) { }
+
+    uint32_t value() const {
+        return v;
+    }
+
+    bool operator==(const PrimeField& other) const {
+        return v == other.v;
+    }
+
+    bool operator!=(const PrimeField& other) const {
+        return v != other.v;
+    }
+
+    PrimeField& operator+=(const PrimeField& other) {
+        v += other.v;
+        if (v >= P)
+            v -= P;
+        return *this;
+    }
+
+    PrimeField& operator-=(const PrimeField& other) {
+        v += P - other.v;
+        if (v >= P)
+            v -= P;
+        return *this;
+    }
+
+    PrimeField& operator*=(const PrimeField& other) {
+        v = static_cast<uint32_t>(static_cast<uint64_t>(v) * other.v % P);
+        return *this;
+    }
+
+    PrimeField& operator/=(const PrimeField& other) {
+        PrimeField inv = 1, a = other;
+        for (uint32_t e = P - 2; e; e >>= 1) {
+            if (e & 1)
+                inv *= a;
+            a *= a;
+        }
+        return *this *= inv;
+    }
+
+    friend PrimeField operator+(PrimeField l, const PrimeField& r) {
+        return l += r;
+    }
+
+    friend PrimeField operator-(PrimeField l, const PrimeField& r) {
+        return l -= r;
+    }
+
+    friend PrimeField operator*(PrimeField l, const PrimeField& r) {
+        return l *= r;
+    }
+
+    friend PrimeField operator/(PrimeField l, const PrimeField& r) {
+        return l /= r;
+    }
+
+    // Lets Matrix::solve pick a nonzero pivot.
+    friend uint32_t abs(const PrimeField& x) {
+        return x.v;
+    }
+};
+
+template<>
+class FieldTraits<PrimeField> {
+public:
+    static bool is_field() {
+        return true;
+    }
+};
@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "unique_ptr.cpp"
+#include "shared_ptr.cpp"
+#include "intrusive_ptr.cpp"
+#include "reclaimer.cpp"
+
+struct Payload {
+    long a, b, c;
+
+    Payload() : a(1), b(2), c(3) { }
+};
+
+struct CountedPayload : RefCounted<CountedPayload> {
+    long a, b, c;
+
+    CountedPayload() : a(1), b(2), c(3) { }
+};
+
+struct AtomicPayload : RefCounted<AtomicPayload, AtomicCounter> {
+    long a, b, c;
+
+    AtomicPayload() : a(1), b(2), c(3) { }
+};
+
+static void BM_UniqueConstructDestroy(benchmark::State& state) {
+    for (auto _ : state) {
+        UniquePtr<Payload> p(new Payload);
+        benchmark::DoNotOptimize(p.get());
+    }
+}
+
+static void BM_SharedConstructDestroy(benchmark::State& state) {
+    for (auto _ : state) {
+        SharedPtr<Payload> p(new Payload);
+        benchmark::DoNotOptimize(p.get());
+    }
+}
+
+static void BM_SharedDeferredDestroy(benchmark::State& state) {
+    Reclaimer r;
+    for (auto _ : state) {
+        SharedPtr<Payload> p = DeferShared(new Payload, r);
+        benchmark::DoNotOptimize(p.get());
+    }
+    r.flush();
+}
+
+template<typename T>
+static void BM_IntrusiveConstructDestroy(benchmark::State& state) {
+    for (auto _ : state) {
+        IntrusivePtr<T> p(new T);
+        benchmark::DoNotOptimize(p.get());
+    }
+}
+
+static void BM_UniqueMove(benchmark::State& state) {
+    UniquePtr<Payload> p(new Payload);
+    for (auto _ : state) {
+        UniquePtr<Payload> q(std::move(p));
+        p = std::move(q);
+        benchmark::DoNotOptimize(p.get());
+    }
+}
+
+// Copies a vector of handles, which is what sharing a batch of objects costs.
+template<typename Ptr>
+static void CopyHandles(benchmark::State& state, std::vector<Ptr>& v) {
+    for (auto _ : state) {
+        std::vector<Ptr> copy = v;
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetItemsProcessed(state.iterations() * v.size());
+}
+
+static void BM_SharedCopy(benchmark::State& state) {
+    std::vector<SharedPtr<Payload>> v;
+    for (long i = 0; i < state.range(0); ++i)
+        v.emplace_back(new Payload);
+    CopyHandles(state, v);
+}
+
+template<typename T>
+static void BM_IntrusiveCopy(benchmark::State& state) {
+    std::vector<IntrusivePtr<T>> v;
+    for (long i = 0; i < state.range(0); ++i)
+        v.emplace_back(new T);
+    CopyHandles(state, v);
+}
+
+BENCHMARK(BM_UniqueConstructDestroy);
+BENCHMARK(BM_SharedConstructDestroy);
+BENCHMARK(BM_SharedDeferredDestroy);
+BENCHMARK_TEMPLATE(BM_IntrusiveConstructDestroy, CountedPayload);
+BENCHMARK_TEMPLATE(BM_IntrusiveConstructDestroy, AtomicPayload);
+BENCHMARK(BM_UniqueMove);
+BENCHMARK(BM_SharedCopy)->Range(64, 65536);
+BENCHMARK_TEMPLATE(BM_IntrusiveCopy, CountedPayload)->Range(64, 65536);
+BENCHMARK_TEMPLATE(BM_IntrusiveCopy, AtomicPayload)->Range(64, 65536);
+
+BENCHMARK_MAIN();
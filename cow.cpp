@@ -0,0 +1,190 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "intrusive_ptr.cpp"
+
+// Copy-on-write holder for a container: copies share one atomically
+// refcounted buffer until write() is called on a shared one. An empty holder
+// owns no buffer and reads as a default-constructed C.
+//
+// Pointers and references obtained through write() stay tied to the buffer:
+// after the owner is copied, writes through them are seen by both copies, so
+// they must be taken again from write() once the owner has been copied.
+// Owners that hand such pointers to their users take them from leak()
+// instead, which makes the buffer unshareable: from then on copies of the
+// holder copy it eagerly, as a plain container would, and the pointers keep
+// referring to this holder's elements only. Assigning to such a holder
+// copies into its buffer in place for the same reason.
+template<typename C>
+class Cow {
+private:
+    class Node : public RefCounted<Node, AtomicCounter> {
+    public:
+        C value;
+        bool leaked = false;
+
+        Node() { }
+
+        Node(const C& v) : value(v) { }
+
+        Node(C&& v) : value(std::move(v)) { }
+    };
+
+    IntrusivePtr<Node> node;
+
+    static const C& empty() {
+        static const C e;
+        return e;
+    }
+
+public:
+    Cow() noexcept { }
+
+    Cow(C v) : node(new Node(std::move(v))) { }
+
+    Cow(const Cow& other)
+        : node(other.node && other.node->leaked ? new Node(other.node->value) : other.node.get()) { }
+
+    Cow(Cow&& other) noexcept = default;
+
+    Cow& operator=(const Cow& other) {
+        if (this == &other)
+            return *this;
+        if (node && node->leaked)
+            node->value = other.read();
+        else
+            *this = Cow(other);
+        return *this;
+    }
+
+    Cow& operator=(Cow&& other) noexcept = default;
+
+    const C& read() const {
+        return node ? node->value : empty();
+    }
+
+    C& write() {
+        if (!node)
+            node = new Node();
+        else if (node->use_count() != 1)
+            node = new Node(node->value);
+        return node->value;
+    }
+
+    // write() for a buffer whose elements are about to be exposed.
+    C& leak() {
+        C& res = write();
+        node->leaked = true;
+        return res;
+    }
+
+    bool shared() const {
+        return node && node->use_count() != 1;
+    }
+};
+
+// Refcounted owner of memory that an ArrayBuffer borrows, e.g. a file mapping.
+class ExternalOwner : public RefCounted<ExternalOwner, AtomicCounter> {
+public:
+    virtual ~ExternalOwner() { }
+};
+
+// Contiguous elements, either owned or borrowed read-only from an
+// ExternalOwner. Borrowed elements are copied into owned storage the first
+// time vec() is asked for them, and whenever the buffer is copied.
+template<typename T>
+class ArrayBuffer {
+private:
+    std::vector<T> own;
+    const T* ext;
+    size_t ext_size;
+    IntrusivePtr<ExternalOwner> keep;
+
+public:
+    ArrayBuffer() : ext(nullptr), ext_size(0) { }
+
+    ArrayBuffer(std::vector<T> v) : own(std::move(v)), ext(nullptr), ext_size(0) { }
+
+    static ArrayBuffer Borrow(const T* p, size_t n, ExternalOwner* owner) {
+        ArrayBuffer res;
+        res.ext = p;
+        res.ext_size = n;
+        res.keep = owner;
+        return res;
+    }
+
+    ArrayBuffer(const ArrayBuffer& other) : own(other.begin(), other.end()), ext(nullptr), ext_size(0) { }
+
+    ArrayBuffer(ArrayBuffer&& other) noexcept
+        : own(std::move(other.own)), ext(other.ext), ext_size(other.ext_size), keep(std::move(other.keep)) {
+        other.ext = nullptr;
+        other.ext_size = 0;
+    }
+
+    // Reuses the owned storage when it is large enough, like std::vector.
+    ArrayBuffer& operator=(const ArrayBuffer& other) {
+        if (this == &other)
+            return *this;
+        own.assign(other.begin(), other.end());
+        ext = nullptr;
+        ext_size = 0;
+        keep.reset();
+        return *this;
+    }
+
+    ArrayBuffer& operator=(ArrayBuffer&& other) noexcept {
+        if (this == &other)
+            return *this;
+        own = std::move(other.own);
+        ext = other.ext;
+        ext_size = other.ext_size;
+        keep = std::move(other.keep);
+        other.ext = nullptr;
+        other.ext_size = 0;
+        return *this;
+    }
+
+    const T* data() const {
+        return ext ? ext : own.data();
+    }
+
+    size_t size() const {
+        return ext ? ext_size : own.size();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    bool borrowed() const {
+        return ext != nullptr;
+    }
+
+    const T* begin() const {
+        return data();
+    }
+
+    const T* end() const {
+        return data() + size();
+    }
+
+    const T& operator[](size_t i) const {
+        return data()[i];
+    }
+
+    const T& back() const {
+        return data()[size() - 1];
+    }
+
+    std::vector<T>& vec() {
+        if (ext) {
+            own.assign(ext, ext + ext_size);
+            ext = nullptr;
+            ext_size = 0;
+            keep.reset();
+        }
+        return own;
+    }
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+// Whether T is a field, i.e. every nonzero value has an exact inverse, so
+// algorithms that divide by arbitrary nonzero values (such as the recurrence
+// in Polynomial::pow) give exact results. Types opt in by specializing this
+// class; the default makes those algorithms fall back to ones that only
+// multiply. is_field() is a function so that types with a run-time modulus
+// can answer per modulus.
+template<typename T>
+class FieldTraits {
+public:
+    static bool is_field() {
+        return false;
+    }
+};
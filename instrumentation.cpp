@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Opt-in counters for the library's operations. With HSE_INSTRUMENT defined
+// (the HSE_INSTRUMENTATION CMake option) every HSE_* macro below owns one
+// static site, so counting is a few relaxed atomic adds with no lookup.
+// Without it the macros expand to nothing and snapshots are empty.
+//
+// Sites are named "<class>.<operation>"; sites sharing a name (e.g. one per
+// template instantiation) are merged in snapshots. Times are inclusive, so a
+// polynomial division also shows up as the multiplications it performs.
+// FLOP counts are nominal: 2mnk for an m x k by k x n product, n^3 for a
+// Gauss-Jordan solve, one per coefficient operation for polynomials.
+
+class OperationStats {
+public:
+    uint64_t calls = 0;
+    uint64_t flops = 0;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    uint64_t nanoseconds = 0;
+};
+
+class InstrumentSite;
+
+class Instrumentation {
+private:
+    static std::mutex& lock() {
+        static std::mutex m;
+        return m;
+    }
+
+    static std::vector<InstrumentSite*>& sites() {
+        static std::vector<InstrumentSite*> s;
+        return s;
+    }
+
+    friend class InstrumentSite;
+
+public:
+#ifdef HSE_INSTRUMENT
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    static std::map<std::string, OperationStats> snapshot();
+
+    static void reset();
+
+    static void write_json(std::ostream& out);
+};
+
+class InstrumentSite {
+public:
+    const char* name;
+    std::atomic<uint64_t> calls, flops, allocations, bytes, nanoseconds;
+
+    explicit InstrumentSite(const char* n)
+        : name(n), calls(0), flops(0), allocations(0), bytes(0), nanoseconds(0) {
+        std::lock_guard<std::mutex> guard(Instrumentation::lock());
+        Instrumentation::sites().push_back(this);
+    }
+
+    InstrumentSite(const InstrumentSite&) = delete;
+    InstrumentSite& operator=(const InstrumentSite&) = delete;
+
+    void add_allocation(uint64_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+};
+
+// Counts one call of a site and adds the lifetime of the scope to its time.
+class ScopedOperation {
+private:
+    InstrumentSite& site;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedOperation(InstrumentSite& s) : site(s), start(std::chrono::steady_clock::now()) {
+        site.calls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ScopedOperation(const ScopedOperation&) = delete;
+    ScopedOperation& operator=(const ScopedOperation&) = delete;
+
+    ~ScopedOperation() {
+        auto d = std::chrono::steady_clock::now() - start;
+        site.nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count(),
+                                   std::memory_order_relaxed);
+    }
+};
+
+inline std::map<std::string, OperationStats> Instrumentation::snapshot() {
+    std::map<std::string, OperationStats> res;
+    std::lock_guard<std::mutex> guard(lock());
+    for (InstrumentSite* s : sites()) {
+        OperationStats& o = res[s->name];
+        o.calls += s->calls.load(std::memory_order_relaxed);
+        o.flops += s->flops.load(std::memory_order_relaxed);
+        o.allocations += s->allocations.load(std::memory_order_relaxed);
+        o.bytes += s->bytes.load(std::memory_order_relaxed);
+        o.nanoseconds += s->nanoseconds.load(std::memory_order_relaxed);
+    }
+    return res;
+}
+
+inline void Instrumentation::reset() {
+    std::lock_guard<std::mutex> guard(lock());
+    for (InstrumentSite* s : sites()) {
+        s->calls.store(0, std::memory_order_relaxed);
+        s->flops.store(0, std::memory_order_relaxed);
+        s->allocations.store(0, std::memory_order_relaxed);
+        s->bytes.store(0, std::memory_order_relaxed);
+        s->nanoseconds.store(0, std::memory_order_relaxed);
+    }
+}
+
+// {"matrix.multiply": {"calls": 3, "flops": ..., ...}, ...}. Site names are
+// identifiers and need no escaping.
+inline void Instrumentation::write_json(std::ostream& out) {
+    std::map<std::string, OperationStats> s = snapshot();
+    out << '{';
+    for (auto it = s.begin(); it != s.end(); ++it) {
+        if (it != s.begin())
+            out << ',';
+        out << "\n  \"" << it->first << "\": {\"calls\": " << it->second.calls
+            << ", \"flops\": " << it->second.flops
+            << ", \"allocations\": " << it->second.allocations
+            << ", \"bytes\": " << it->second.bytes
+            << ", \"nanoseconds\": " << it->second.nanoseconds << '}';
+    }
+    out << (s.empty() ? "}" : "\n}") << '\n';
+}
+
+#define HSE_CONCAT_IMPL(a, b) a##b
+#define HSE_CONCAT(a, b) HSE_CONCAT_IMPL(a, b)
+
+#ifdef HSE_INSTRUMENT
+#define HSE_SITE(name) ([]() -> InstrumentSite& { static InstrumentSite s(name); return s; }())
+#define HSE_SCOPED_OP(name) ScopedOperation HSE_CONCAT(hse_scoped_op_, __LINE__)(HSE_SITE(name))
+#define HSE_COUNT_FLOPS(name, n) HSE_SITE(name).flops.fetch_add((n), std::memory_order_relaxed)
+#define HSE_COUNT_ALLOC(name, size) HSE_SITE(name).add_allocation(size)
+#else
+#define HSE_SCOPED_OP(name) ((void)0)
+#define HSE_COUNT_FLOPS(name, n) ((void)0)
+#define HSE_COUNT_ALLOC(name, size) ((void)0)
+#endif
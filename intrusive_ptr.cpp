@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+
+class UnsyncCounter {
+public:
+    using type = size_t;
+
+    static size_t load(const type& c) noexcept {
+        return c;
+    }
+
+    static void inc(type& c) noexcept {
+        ++c;
+    }
+
+    static size_t dec(type& c) noexcept {
+        return --c;
+    }
+};
+
+class AtomicCounter {
+public:
+    using type = std::atomic<size_t>;
+
+    static size_t load(const type& c) noexcept {
+        return c.load(std::memory_order_acquire);
+    }
+
+    static void inc(type& c) noexcept {
+        c.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static size_t dec(type& c) noexcept {
+        return c.fetch_sub(1, std::memory_order_acq_rel) - 1;
+    }
+};
+
+// Base class keeping the reference count inside the object. Types that cannot
+// inherit from it may instead provide their own intrusive_ptr_add_ref and
+// intrusive_ptr_release overloads found by argument-dependent lookup.
+template<typename T, typename Counter = UnsyncCounter>
+class RefCounted {
+private:
+    mutable typename Counter::type ref_cnt;
+
+protected:
+    RefCounted() noexcept : ref_cnt(0) { }
+
+    RefCounted(const RefCounted&) noexcept : ref_cnt(0) { }
+
+    RefCounted& operator=(const RefCounted&) noexcept {
+        return *this;
+    }
+
+    ~RefCounted() { }
+
+public:
+    size_t use_count() const noexcept {
+        return Counter::load(ref_cnt);
+    }
+
+    friend void intrusive_ptr_add_ref(const RefCounted* p) noexcept {
+        Counter::inc(p->ref_cnt);
+    }
+
+    friend void intrusive_ptr_release(const RefCounted* p) noexcept {
+        if (!Counter::dec(p->ref_cnt))
+            delete static_cast<const T*>(p);
+    }
+};
+
+template<typename T>
+class IntrusivePtr {
+private:
+    T* ptr;
+
+    void inc() {
+        if (ptr != nullptr)
+            intrusive_ptr_add_ref(ptr);
+    }
+
+    void dec() {
+        if (ptr != nullptr) {
+            T* p = ptr;
+            ptr = nullptr;
+            intrusive_ptr_release(p);
+        }
+    }
+
+public:
+    IntrusivePtr() noexcept : ptr(nullptr) { }
+
+    IntrusivePtr(T* p) : ptr(p) {
+        inc();
+    }
+
+    IntrusivePtr(const IntrusivePtr& other) noexcept : ptr(other.ptr) {
+        inc();
+    }
+
+    IntrusivePtr(IntrusivePtr&& other) noexcept : ptr(other.ptr) {
+        other.ptr = nullptr;
+    }
+
+    IntrusivePtr& operator=(T* p) {
+        reset(p);
+        return *this;
+    }
+
+    IntrusivePtr& operator=(const IntrusivePtr& other) noexcept {
+        reset(other.ptr);
+        return *this;
+    }
+
+    IntrusivePtr& operator=(IntrusivePtr&& other) noexcept {
+        if (this == &other)
+            return *this;
+        dec();
+        ptr = other.ptr;
+        other.ptr = nullptr;
+        return *this;
+    }
+
+    ~IntrusivePtr() noexcept {
+        dec();
+    }
+
+    const T& operator*() const noexcept {
+        return *ptr;
+    }
+
+    T& operator*() noexcept {
+        return *ptr;
+    }
+
+    T* operator->() noexcept {
+        return ptr;
+    }
+
+    const T* operator->() const noexcept {
+        return ptr;
+    }
+
+    void reset(T* p) {
+        if (p != nullptr)
+            intrusive_ptr_add_ref(p);
+        dec();
+        ptr = p;
+    }
+
+    void reset() {
+        dec();
+    }
+
+    void swap(IntrusivePtr& other) noexcept {
+        std::swap(ptr, other.ptr);
+    }
+
+    T* get() const noexcept {
+        return ptr;
+    }
+
+    explicit operator bool() const noexcept {
+        return ptr != nullptr;
+    }
+};
@@ -1,21 +1,107 @@
+#pragma once
+
 #include <vector>
 #include <utility>
 #include <algorithm>
 #include <iostream>
 #include <cmath>
+#include <limits>
+#include <array>
+#include <type_traits>
+#include <stdexcept>
+
+#include "cow.cpp"
+#include "instrumentation.cpp"
+
+constexpr size_t DynamicExtent = 0;
+
+// Matrix<T> is sized at runtime. Matrix<T, R, C> has compile-time extents,
+// keeps its elements inline and checks the dimensions of products statically.
+template<typename T, size_t R = DynamicExtent, size_t C = DynamicExtent>
+class Matrix;
 
 template<typename T>
-class Matrix {
+class IsMatrix : public std::false_type { };
+
+template<typename T, size_t R, size_t C>
+class IsMatrix<Matrix<T, R, C>> : public std::true_type { };
+
+template<typename T>
+class MatrixView;
+
+template<typename T>
+class IsMatrixView : public std::false_type { };
+
+template<typename T>
+class IsMatrixView<MatrixView<T>> : public std::true_type { };
+
+template<typename T>
+class Matrix<T, DynamicExtent, DynamicExtent> {
 private:
     size_t rows, cols;
-    std::vector<std::vector<T>> m;
+    Cow<ArrayBuffer<T>> m;
     class iterator;
     class const_iterator;
 
+    // Unshares the buffer before a write; this is where copies of a Matrix
+    // actually allocate.
+    std::vector<T>& storage() {
+#ifdef HSE_INSTRUMENT
+        if (m.shared() || m.read().borrowed())
+            HSE_COUNT_ALLOC("matrix.copy", rows * cols * sizeof(T));
+#endif
+        return m.write().vec();
+    }
+
+    // storage() for pointers and references handed out to users. The buffer
+    // stops being shared lazily, so copies made afterwards get their own
+    // elements and never see writes through what was handed out.
+    T* exposed() {
+        storage();
+        return m.leak().vec().data();
+    }
+
+    // A mutable view for the matrix's own operations, which do not let it
+    // escape, so the buffer stays shareable.
+    MatrixView<T> internal_view() {
+        return MatrixView<T>(storage().data(), rows, cols, cols, 1);
+    }
+
 public:
-    Matrix(const std::vector<std::vector<T>>& v) : m(v) {
+    Matrix(const std::vector<std::vector<T>>& v) {
         rows = v.size();
         cols = (v.empty() ? 0 : v[0].size());
+        HSE_COUNT_ALLOC("matrix.alloc", rows * cols * sizeof(T));
+        std::vector<T>& d = m.write().vec();
+        d.reserve(rows * cols);
+        for (size_t i = 0; i < rows; ++i)
+            d.insert(d.end(), v[i].begin(), v[i].end());
+    }
+
+    Matrix(size_t r, size_t c) : rows(r), cols(c), m(ArrayBuffer<T>(std::vector<T>(r * c, T()))) {
+        HSE_COUNT_ALLOC("matrix.alloc", r * c * sizeof(T));
+    }
+
+    explicit Matrix(const MatrixView<const T>& v);
+
+    Matrix(size_t r, size_t c, ArrayBuffer<T> data) : rows(r), cols(c), m(std::move(data)) { }
+
+    Matrix(const Matrix& other) = default;
+
+    Matrix(Matrix&& other) noexcept : rows(other.rows), cols(other.cols), m(std::move(other.m)) {
+        other.rows = other.cols = 0;
+    }
+
+    Matrix& operator=(const Matrix& other) = default;
+
+    Matrix& operator=(Matrix&& other) noexcept {
+        if (this == &other)
+            return *this;
+        rows = other.rows;
+        cols = other.cols;
+        m = std::move(other.m);
+        other.rows = other.cols = 0;
+        return *this;
     }
 
     iterator begin() {
@@ -42,17 +128,73 @@ public:
 
     Matrix& operator+=(const Matrix& other);
 
+    Matrix& operator+=(const MatrixView<const T>& other);
+
     template<typename TI>
-    Matrix& operator*=(const TI& other);
+    std::enable_if_t<!IsMatrixView<TI>::value, Matrix&> operator*=(const TI& other);
 
     Matrix& operator*=(const Matrix& other);
 
+    Matrix& operator*=(const MatrixView<const T>& other);
+
     Matrix& transpose();
 
     Matrix transposed() const;
 
     template<typename U>
     std::vector<U> solve(const std::vector<U>& b) const;
+
+    // Factors in Low, refines in U; see SolveRefined.
+    template<typename Low = float, typename U>
+    std::vector<U> solve_refined(const std::vector<U>& b, U tol = U()) const;
+
+    MatrixView<T> view() {
+        return MatrixView<T>(exposed(), rows, cols, cols, 1);
+    }
+
+    MatrixView<const T> view() const {
+        return MatrixView<const T>(m.read().data(), rows, cols, cols, 1);
+    }
+
+    operator MatrixView<T>() {
+        return view();
+    }
+
+    operator MatrixView<const T>() const {
+        return view();
+    }
+
+    MatrixView<T> block(size_t i, size_t j, size_t r, size_t c) {
+        return MatrixView<T>(exposed() + i * cols + j, r, c, cols, 1);
+    }
+
+    MatrixView<const T> block(size_t i, size_t j, size_t r, size_t c) const {
+        return MatrixView<const T>(m.read().data() + i * cols + j, r, c, cols, 1);
+    }
+
+    MatrixView<T> row(size_t i) {
+        return block(i, 0, 1, cols);
+    }
+
+    MatrixView<const T> row(size_t i) const {
+        return block(i, 0, 1, cols);
+    }
+
+    MatrixView<T> col(size_t j) {
+        return block(0, j, rows, 1);
+    }
+
+    MatrixView<const T> col(size_t j) const {
+        return block(0, j, rows, 1);
+    }
+
+    MatrixView<T> diagonal() {
+        return MatrixView<T>(exposed(), std::min(rows, cols), 1, cols + 1, 1);
+    }
+
+    MatrixView<const T> diagonal() const {
+        return MatrixView<const T>(m.read().data(), std::min(rows, cols), 1, cols + 1, 1);
+    }
 };
 
 template<typename T>
@@ -137,23 +279,439 @@ public:
     }
 };
 
+// Non-owning strided window into a Matrix<T> (or any row-major buffer):
+// element (i, j) lives at data[i * row_stride + j * col_stride]. Blocks, rows,
+// columns and the diagonal are all views, and transposing one just swaps the
+// strides. Writes go straight to the viewed matrix, which must outlive the view.
+template<typename T>
+class MatrixView {
+private:
+    using E = std::remove_const_t<T>;
+
+    T* data;
+    size_t rows, cols, rs, cs;
+
+    const T* last() const {
+        return data + (rows ? rows - 1 : 0) * rs + (cols ? cols - 1 : 0) * cs;
+    }
+
+    template<typename U>
+    friend class MatrixView;
+
+public:
+    class iterator;
+
+    MatrixView(T* d, size_t r, size_t c, size_t row_stride, size_t col_stride)
+        : data(d), rows(r), cols(c), rs(row_stride), cs(col_stride) { }
+
+    template<typename U, typename = std::enable_if_t<std::is_same<const U, T>::value>>
+    MatrixView(const MatrixView<U>& other)
+        : data(other.ptr()), rows(other.size().first), cols(other.size().second),
+          rs(other.strides().first), cs(other.strides().second) { }
+
+    iterator begin() const {
+        return iterator(0, 0, *this);
+    }
+
+    iterator end() const {
+        return iterator(rows, 0, *this);
+    }
+
+    std::pair<size_t, size_t> size() const {
+        return {rows, cols};
+    }
+
+    std::pair<size_t, size_t> strides() const {
+        return {rs, cs};
+    }
+
+    T* ptr() const {
+        return data;
+    }
+
+    bool overlaps(const MatrixView<const E>& other) const {
+        return !(last() < other.ptr() || other.last() < data) && rows && cols;
+    }
+
+    T& operator()(size_t i, size_t j) const {
+        return data[i * rs + j * cs];
+    }
+
+    MatrixView block(size_t i, size_t j, size_t r, size_t c) const {
+        return MatrixView(data + i * rs + j * cs, r, c, rs, cs);
+    }
+
+    MatrixView row(size_t i) const {
+        return block(i, 0, 1, cols);
+    }
+
+    MatrixView col(size_t j) const {
+        return block(0, j, rows, 1);
+    }
+
+    MatrixView diagonal() const {
+        return MatrixView(data, std::min(rows, cols), 1, rs + cs, cs);
+    }
+
+    MatrixView transposed() const {
+        return MatrixView(data, cols, rows, cs, rs);
+    }
+
+    const MatrixView& assign(const MatrixView<const E>& other) const;
+
+    const MatrixView& operator+=(const MatrixView<const E>& other) const;
+
+    template<typename TI>
+    std::enable_if_t<!IsMatrix<TI>::value && !IsMatrixView<TI>::value, const MatrixView&>
+    operator*=(const TI& other) const;
+
+    const MatrixView& operator*=(const MatrixView<const E>& other) const;
+
+    const MatrixView& transpose() const;
+
+    template<typename U>
+    std::vector<U> solve(const std::vector<U>& b) const;
+
+    // Factors in Low, refines in U; see SolveRefined.
+    template<typename Low = float, typename U>
+    std::vector<U> solve_refined(const std::vector<U>& b, U tol = U()) const;
+};
+
+template<typename T>
+class MatrixView<T>::iterator {
+private:
+    size_t i, j;
+    MatrixView<T> ref;
+
+public:
+    iterator(size_t a, size_t b, const MatrixView<T>& r) : i(a), j(b), ref(r) { }
+
+    iterator operator++() {
+        ++j;
+        if (j >= ref.size().second) {
+            ++i;
+            j = 0;
+        }
+        return *this;
+    }
+
+    iterator operator++(int) {
+        iterator prev = *this;
+        ++j;
+        if (j >= ref.size().second) {
+            ++i;
+            j = 0;
+        }
+        return prev;
+    }
+
+    T& operator*() const {
+        return ref(i, j);
+    }
+
+    bool operator==(const iterator& other) {
+        return (i == other.i) && (j == other.j);
+    }
+
+    bool operator!=(const iterator& other) {
+        return !(*this == other);
+    }
+};
+
+// res (l.rows x r.cols, row-major, zero-filled) += l * r. This and SolveSystem
+// are called unqualified, so element types can overload them (see modint.cpp).
+template<typename T, typename L, typename R>
+void MultiplyInto(T* res, const MatrixView<L>& l, const MatrixView<R>& r) {
+    size_t rows = l.size().first, inner = l.size().second, cols = r.size().second;
+    for (size_t i = 0; i != rows; ++i)
+        for (size_t k = 0; k != inner; ++k) {
+            T a = l(i, k);
+            T* out = res + i * cols;
+            for (size_t j = 0; j != cols; ++j)
+                out[j] += a * r(k, j);
+        }
+}
+
+// Runtime dimension mismatches throw std::invalid_argument.
+inline void CheckSolveShape(size_t rows, size_t cols, size_t b) {
+    if (rows != cols)
+        throw std::invalid_argument("solve needs a square matrix");
+    if (b != rows)
+        throw std::invalid_argument("right-hand side size does not match the matrix");
+}
+
+// Gauss-Jordan elimination with partial pivoting on a copy of a, augmented
+// with b. Rows live in one flat buffer and pivoting swaps row pointers.
+template<typename U, typename T>
+std::vector<U> SolveSystem(const MatrixView<T>& a, const std::vector<U>& b) {
+    size_t n = a.size().first;
+    std::vector<U> buf(n * (n + 1));
+    std::vector<U*> s(n);
+    for (size_t i = 0; i < n; ++i) {
+        s[i] = buf.data() + i * (n + 1);
+        for (size_t j = 0; j < n; ++j)
+            s[i][j] = static_cast<U>(a(i, j));
+        s[i][n] = b[i];
+    }
+
+    using std::abs;
+    for (size_t j = 0; j < n; ++j) {
+        size_t maxi = j;
+        for (size_t i = j + 1; i < n; ++i)
+            if (abs(s[i][j]) > abs(s[maxi][j]))
+                maxi = i;
+        std::swap(s[j], s[maxi]);
+        for (size_t i = 0; i < n; ++i) {
+            if (i == j)
+                continue;
+            U d = s[i][j] / s[j][j];
+            for (size_t k = j; k <= n; ++k)
+                s[i][k] -= s[j][k] * d;
+        }
+    }
+
+    std::vector<U> ans(n);
+    for (size_t i = 0; i < n; ++i)
+        ans[i] = s[i][n] / s[i][i];
+    return ans;
+}
+
+// LU factorization with partial pivoting, P * a = L * U, with both factors
+// in one row-major buffer so several right-hand sides reuse it. Elimination
+// updates whole contiguous rows, which vectorizes.
+template<typename U>
+class LuFactorization {
+private:
+    size_t n;
+    std::vector<U> lu;
+    std::vector<size_t> perm;
+    bool ok;
+
+public:
+    template<typename T>
+    explicit LuFactorization(const MatrixView<T>& a)
+        : n(a.size().first), lu(n * n), perm(n), ok(true) {
+        using std::abs;
+        for (size_t i = 0; i < n; ++i) {
+            perm[i] = i;
+            for (size_t j = 0; j < n; ++j)
+                lu[i * n + j] = static_cast<U>(a(i, j));
+        }
+        for (size_t k = 0; k < n; ++k) {
+            size_t maxi = k;
+            for (size_t i = k + 1; i < n; ++i)
+                if (abs(lu[i * n + k]) > abs(lu[maxi * n + k]))
+                    maxi = i;
+            if (lu[maxi * n + k] == U()) {
+                ok = false;
+                return;
+            }
+            if (maxi != k) {
+                std::swap_ranges(lu.begin() + k * n, lu.begin() + (k + 1) * n, lu.begin() + maxi * n);
+                std::swap(perm[k], perm[maxi]);
+            }
+            const U* pivot = lu.data() + k * n;
+            for (size_t i = k + 1; i < n; ++i) {
+                U* row = lu.data() + i * n;
+                U l = row[k] /= pivot[k];
+                for (size_t j = k + 1; j < n; ++j)
+                    row[j] -= l * pivot[j];
+            }
+        }
+    }
+
+    bool singular() const {
+        return !ok;
+    }
+
+    std::vector<U> solve(const std::vector<U>& b) const {
+        std::vector<U> x(n);
+        for (size_t i = 0; i < n; ++i) {
+            U s = b[perm[i]];
+            for (size_t j = 0; j < i; ++j)
+                s -= lu[i * n + j] * x[j];
+            x[i] = s;
+        }
+        for (size_t i = n; i-- > 0;) {
+            U s = x[i];
+            for (size_t j = i + 1; j < n; ++j)
+                s -= lu[i * n + j] * x[j];
+            x[i] = s / lu[i * n + i];
+        }
+        return x;
+    }
+};
+
+// Mixed-precision solve: a is factored once in the cheaper type Low and the
+// solution is refined with residuals b - a * x computed in U, each step
+// costing O(n^2) against the O(n^3) factorization. Iteration stops once
+// ||r|| <= tol * ||a|| * ||x|| in max norms (tol defaults to sqrt(n) times the
+// epsilon of U). If the factorization is singular in Low, a correction fails
+// to halve, or the iteration limit is reached, the system is solved again by
+// SolveSystem in U, so the result is never worse than solve<U>. The setup
+// only pays off for systems of roughly a hundred unknowns and more.
+template<typename Low, typename U, typename T>
+std::vector<U> SolveRefined(const MatrixView<T>& a, const std::vector<U>& b, U tol = U()) {
+    using std::abs;
+    const size_t max_iterations = 30;
+    size_t n = a.size().first;
+    if (tol <= U())
+        tol = std::numeric_limits<U>::epsilon() * std::sqrt(static_cast<U>(std::max<size_t>(n, 1)));
+
+    HSE_COUNT_FLOPS("matrix.solve_refined", 2 * n * n * n / 3);
+    LuFactorization<Low> lu(a);
+    if (!lu.singular()) {
+        U norm = U();
+        for (size_t i = 0; i < n; ++i) {
+            U s = U();
+            for (size_t j = 0; j < n; ++j)
+                s += abs(static_cast<U>(a(i, j)));
+            norm = std::max(norm, s);
+        }
+
+        std::vector<U> x(n, U());
+        std::vector<Low> r(n);
+        U last = U();
+        for (size_t it = 0; it <= max_iterations; ++it) {
+            U rnorm = U(), xnorm = U();
+            for (size_t i = 0; i < n; ++i) {
+                U s = b[i];
+                for (size_t j = 0; j < n; ++j)
+                    s -= static_cast<U>(a(i, j)) * x[j];
+                r[i] = static_cast<Low>(s);
+                rnorm = std::max(rnorm, abs(s));
+                xnorm = std::max(xnorm, abs(x[i]));
+            }
+            if (rnorm <= tol * norm * xnorm)
+                return x;
+            if (!(rnorm < std::numeric_limits<U>::infinity()))
+                break;
+
+            // The first step is the plain low-precision solution; every
+            // later one is a correction and has to shrink to make progress.
+            std::vector<Low> d = lu.solve(r);
+            U dnorm = U();
+            for (size_t i = 0; i < n; ++i)
+                dnorm = std::max(dnorm, abs(static_cast<U>(d[i])));
+            if (it > 1 && !(dnorm < last / 2))
+                break;
+            last = dnorm;
+            for (size_t i = 0; i < n; ++i)
+                x[i] += static_cast<U>(d[i]);
+        }
+    }
+    HSE_SCOPED_OP("matrix.solve_refined_fallback");
+    HSE_COUNT_FLOPS("matrix.solve_refined_fallback", n * n * n);
+    return SolveSystem(a, b);
+}
+
+template<typename T>
+const MatrixView<T>& MatrixView<T>::assign(const MatrixView<const E>& other) const {
+    if (overlaps(other))
+        return assign(Matrix<E>(other));
+    for (size_t i = 0; i != rows; ++i)
+        for (size_t j = 0; j != cols; ++j)
+            (*this)(i, j) = other(i, j);
+    return *this;
+}
+
+template<typename T>
+const MatrixView<T>& MatrixView<T>::operator+=(const MatrixView<const E>& other) const {
+    if (overlaps(other))
+        return *this += Matrix<E>(other);
+    HSE_SCOPED_OP("matrix.add");
+    HSE_COUNT_FLOPS("matrix.add", rows * cols);
+    for (size_t i = 0; i != rows; ++i)
+        for (size_t j = 0; j != cols; ++j)
+            (*this)(i, j) += other(i, j);
+    return *this;
+}
+
+template<typename T>
+template<typename TI>
+std::enable_if_t<!IsMatrix<TI>::value && !IsMatrixView<TI>::value, const MatrixView<T>&>
+MatrixView<T>::operator*=(const TI& other) const {
+    HSE_SCOPED_OP("matrix.scale");
+    HSE_COUNT_FLOPS("matrix.scale", rows * cols);
+    for (size_t i = 0; i != rows; ++i)
+        for (size_t j = 0; j != cols; ++j)
+            (*this)(i, j) *= other;
+    return *this;
+}
+
+// The right operand must be square (cols x cols) so the view keeps its shape.
+template<typename T>
+const MatrixView<T>& MatrixView<T>::operator*=(const MatrixView<const E>& other) const {
+    HSE_SCOPED_OP("matrix.multiply");
+    HSE_COUNT_FLOPS("matrix.multiply", 2 * rows * cols * cols);
+    HSE_COUNT_ALLOC("matrix.alloc", rows * cols * sizeof(E));
+    std::vector<E> res(rows * cols, E());
+    MultiplyInto(res.data(), MatrixView<const E>(*this), other);
+    for (size_t i = 0; i != rows; ++i)
+        for (size_t j = 0; j != cols; ++j)
+            (*this)(i, j) = res[i * cols + j];
+    return *this;
+}
+
+// Square views only. Works in tiles so both sides of each swap stay in cache.
+template<typename T>
+const MatrixView<T>& MatrixView<T>::transpose() const {
+    if (rows != cols)
+        throw std::invalid_argument("in-place transpose needs a square view, use transposed()");
+    HSE_SCOPED_OP("matrix.transpose");
+    const size_t tile = 16;
+    for (size_t ii = 0; ii < rows; ii += tile)
+        for (size_t jj = ii; jj < cols; jj += tile)
+            for (size_t i = ii; i != std::min(rows, ii + tile); ++i)
+                for (size_t j = std::max(jj, i + 1); j < std::min(cols, jj + tile); ++j)
+                    std::swap((*this)(i, j), (*this)(j, i));
+    return *this;
+}
+
+template<typename T>
+template<typename U>
+std::vector<U> MatrixView<T>::solve(const std::vector<U>& b) const {
+    CheckSolveShape(rows, cols, b.size());
+    HSE_SCOPED_OP("matrix.solve");
+    HSE_COUNT_FLOPS("matrix.solve", rows * rows * rows);
+    return SolveSystem(*this, b);
+}
+
+template<typename T>
+template<typename Low, typename U>
+std::vector<U> MatrixView<T>::solve_refined(const std::vector<U>& b, U tol) const {
+    CheckSolveShape(rows, cols, b.size());
+    HSE_SCOPED_OP("matrix.solve_refined");
+    return SolveRefined<Low>(*this, b, tol);
+}
+
 template<typename T>
 std::pair<size_t, size_t> Matrix<T>::size() const {
      return {rows, cols};
 }
 
+template<typename T>
+Matrix<T>::Matrix(const MatrixView<const T>& v) : rows(v.size().first), cols(v.size().second) {
+    HSE_COUNT_ALLOC("matrix.alloc", rows * cols * sizeof(T));
+    std::vector<T>& d = m.write().vec();
+    d.reserve(rows * cols);
+    for (size_t i = 0; i != rows; ++i)
+        for (size_t j = 0; j != cols; ++j)
+            d.push_back(v(i, j));
+}
+
 template<typename T>
 const T& Matrix<T>::operator()(size_t i, size_t j) const {
-    return m[i][j];
+    return m.read()[i * cols + j];
 }
 
 template<typename T>
 T& Matrix<T>::operator()(size_t i, size_t j) {
-    return m[i][j];
+    return exposed()[i * cols + j];
 }
 
-template<typename T>
-std::ostream& operator<<(std::ostream& out, const Matrix<T>& m) {
+template<typename T, size_t R, size_t C>
+std::ostream& operator<<(std::ostream& out, const Matrix<T, R, C>& m) {
     for (size_t i = 0; i < m.size().first; ++i) {
         if (i)
             out << '\n';
@@ -166,30 +724,46 @@ std::ostream& operator<<(std::ostream& out, const Matrix<T>& m) {
 
 template<typename T>
 Matrix<T>& Matrix<T>::operator+=(const Matrix<T>& other) {
-    for (size_t i = 0; i != rows; ++i)
-        for (size_t j = 0; j != cols; ++j)
-            m[i][j] += other(i, j);
+    HSE_SCOPED_OP("matrix.add");
+    HSE_COUNT_FLOPS("matrix.add", rows * cols);
+    std::vector<T>& d = storage();
+    const ArrayBuffer<T>& o = other.m.read();
+    for (size_t i = 0; i != d.size(); ++i)
+        d[i] += o[i];
+    return *this;
+}
+
+template<typename T>
+Matrix<T>& Matrix<T>::operator+=(const MatrixView<const T>& other) {
+    internal_view() += other;
     return *this;
 }
 
 template<typename T>
 template<typename TI>
-Matrix<T>& Matrix<T>::operator*=(const TI& other) {
-    for (size_t i = 0; i != rows; ++i)
-        for (size_t j = 0; j != cols; ++j)
-            m[i][j] *= other;
+std::enable_if_t<!IsMatrixView<TI>::value, Matrix<T>&> Matrix<T>::operator*=(const TI& other) {
+    HSE_SCOPED_OP("matrix.scale");
+    HSE_COUNT_FLOPS("matrix.scale", rows * cols);
+    std::vector<T>& d = storage();
+    for (size_t i = 0; i != d.size(); ++i)
+        d[i] *= other;
     return *this;
 }
 
 template<typename T>
 Matrix<T>& Matrix<T>::operator*=(const Matrix<T>& other) {
-    std::vector<std::vector<T>> res(rows, std::vector<T>(other.cols, T()));
-    for (size_t i = 0; i != rows; ++i)
-        for (size_t j = 0; j != cols; ++j)
-            for (size_t k = 0; k != other.cols; ++k)
-                res[i][k] += m[i][j] * other.m[j][k];
-    m = res;
-    cols = other.cols;
+    return *this *= other.view();
+}
+
+template<typename T>
+Matrix<T>& Matrix<T>::operator*=(const MatrixView<const T>& other) {
+    HSE_SCOPED_OP("matrix.multiply");
+    HSE_COUNT_FLOPS("matrix.multiply", 2 * rows * cols * other.size().second);
+    HSE_COUNT_ALLOC("matrix.alloc", rows * other.size().second * sizeof(T));
+    std::vector<T> res(rows * other.size().second, T());
+    MultiplyInto(res.data(), std::as_const(*this).view(), other);
+    m = ArrayBuffer<T>(std::move(res));
+    cols = other.size().second;
     return *this;
 }
 
@@ -221,51 +795,312 @@ Matrix<T> operator*(const Matrix<T>& l, const Matrix<T>& r) {
     return res;
 }
 
+// Temporaries on either side of a sum or a scaling are updated in place
+// instead of being copied.
+template<typename T>
+Matrix<T> operator+(Matrix<T>&& l, const Matrix<T>& r) {
+    l += r;
+    return std::move(l);
+}
+
+template<typename T>
+Matrix<T> operator+(const Matrix<T>& l, Matrix<T>&& r) {
+    r += l;
+    return std::move(r);
+}
+
+template<typename T>
+Matrix<T> operator+(Matrix<T>&& l, Matrix<T>&& r) {
+    l += r;
+    return std::move(l);
+}
+
+template<typename T, typename TI>
+std::enable_if_t<!IsMatrix<TI>::value && !IsMatrixView<TI>::value, Matrix<T>>
+operator*(Matrix<T>&& l, const TI& r) {
+    l *= r;
+    return std::move(l);
+}
+
+template<typename T, typename TI>
+std::enable_if_t<!IsMatrix<TI>::value && !IsMatrixView<TI>::value, Matrix<T>>
+operator*(const TI& l, Matrix<T>&& r) {
+    r *= l;
+    return std::move(r);
+}
+
 template<typename T>
 Matrix<T>& Matrix<T>::transpose() {
-    std::vector<std::vector<T>> res(cols, std::vector<T>(rows));
-    for (size_t i = 0; i != rows; ++i)
-        for (size_t j = 0; j != cols; ++j)
-            res[j][i] = m[i][j];
-    m = res;
-    std::swap(rows, cols);
+    if (rows == cols) {
+        internal_view().transpose();
+        return *this;
+    }
+    HSE_SCOPED_OP("matrix.transpose");
+    *this = transposed();
     return *this;
 }
 
 template<typename T>
 Matrix<T> Matrix<T>::transposed() const {
-    Matrix<T> res = *this;
-    res.transpose();
-    return res;
+    return Matrix<T>(view().transposed());
 }
 
 template<typename T>
 template<typename U>
 std::vector<U> Matrix<T>::solve(const std::vector<U>& b) const {
-    std::vector<std::vector<U>> s(rows, std::vector<U>(cols));
-    for (size_t i = 0; i < s.size(); ++i)
-        for (size_t j = 0; j < s.size(); ++j)
+    CheckSolveShape(rows, cols, b.size());
+    HSE_SCOPED_OP("matrix.solve");
+    HSE_COUNT_FLOPS("matrix.solve", rows * rows * rows);
+    return SolveSystem(view(), b);
+}
+
+template<typename T>
+template<typename Low, typename U>
+std::vector<U> Matrix<T>::solve_refined(const std::vector<U>& b, U tol) const {
+    CheckSolveShape(rows, cols, b.size());
+    HSE_SCOPED_OP("matrix.solve_refined");
+    return SolveRefined<Low>(view(), b, tol);
+}
+
+template<typename T, size_t R, size_t C>
+class Matrix {
+private:
+    static_assert(R != DynamicExtent && C != DynamicExtent, "use Matrix<T> for runtime sizes");
+
+    T m[R][C];
+
+public:
+    Matrix() : m() { }
+
+    Matrix(const T (&v)[R][C]) {
+        for (size_t i = 0; i != R; ++i)
+            for (size_t j = 0; j != C; ++j)
+                m[i][j] = v[i][j];
+    }
+
+    explicit Matrix(const Matrix<T>& other) {
+        if (other.size() != std::make_pair(R, C))
+            throw std::invalid_argument("matrix does not have the fixed dimensions");
+        for (size_t i = 0; i != R; ++i)
+            for (size_t j = 0; j != C; ++j)
+                m[i][j] = other(i, j);
+    }
+
+    Matrix<T> dynamic() const {
+        std::vector<std::vector<T>> v(R, std::vector<T>(C));
+        for (size_t i = 0; i != R; ++i)
+            for (size_t j = 0; j != C; ++j)
+                v[i][j] = m[i][j];
+        return Matrix<T>(v);
+    }
+
+    T* begin() {
+        return &m[0][0];
+    }
+
+    T* end() {
+        return &m[0][0] + R * C;
+    }
+
+    const T* begin() const {
+        return &m[0][0];
+    }
+
+    const T* end() const {
+        return &m[0][0] + R * C;
+    }
+
+    static constexpr std::pair<size_t, size_t> size() {
+        return {R, C};
+    }
+
+    const T& operator()(size_t i, size_t j) const {
+        return m[i][j];
+    }
+
+    T& operator()(size_t i, size_t j) {
+        return m[i][j];
+    }
+
+    Matrix& operator+=(const Matrix& other);
+
+    template<typename TI>
+    std::enable_if_t<!IsMatrix<TI>::value, Matrix&> operator*=(const TI& other);
+
+    Matrix& operator*=(const Matrix<T, C, C>& other);
+
+    Matrix& transpose();
+
+    Matrix<T, C, R> transposed() const;
+
+    Matrix inverse() const;
+
+    template<typename U>
+    std::array<U, R> solve(const std::array<U, R>& b) const;
+
+    template<typename U>
+    std::vector<U> solve(const std::vector<U>& b) const;
+};
+
+template<typename T, size_t R, size_t C>
+Matrix<T, R, C>& Matrix<T, R, C>::operator+=(const Matrix<T, R, C>& other) {
+    for (size_t i = 0; i != R; ++i)
+        for (size_t j = 0; j != C; ++j)
+            m[i][j] += other.m[i][j];
+    return *this;
+}
+
+template<typename T, size_t R, size_t C>
+template<typename TI>
+std::enable_if_t<!IsMatrix<TI>::value, Matrix<T, R, C>&> Matrix<T, R, C>::operator*=(const TI& other) {
+    for (size_t i = 0; i != R; ++i)
+        for (size_t j = 0; j != C; ++j)
+            m[i][j] *= other;
+    return *this;
+}
+
+// Row-broadcast order (i, k, j): with compile-time bounds the compiler fully
+// unrolls this and vectorizes the innermost loop over a row of the result.
+template<typename T, size_t R, size_t K, size_t C>
+std::enable_if_t<R != DynamicExtent && K != DynamicExtent && C != DynamicExtent, Matrix<T, R, C>>
+operator*(const Matrix<T, R, K>& l, const Matrix<T, K, C>& r) {
+    Matrix<T, R, C> res;
+    for (size_t i = 0; i != R; ++i)
+        for (size_t k = 0; k != K; ++k) {
+            T a = l(i, k);
+            for (size_t j = 0; j != C; ++j)
+                res(i, j) += a * r(k, j);
+        }
+    return res;
+}
+
+template<typename T, size_t R, size_t C>
+Matrix<T, R, C>& Matrix<T, R, C>::operator*=(const Matrix<T, C, C>& other) {
+    *this = *this * other;
+    return *this;
+}
+
+template<typename T, size_t R, size_t C>
+std::enable_if_t<R != DynamicExtent && C != DynamicExtent, Matrix<T, R, C>>
+operator+(const Matrix<T, R, C>& l, const Matrix<T, R, C>& r) {
+    Matrix<T, R, C> res = l;
+    res += r;
+    return res;
+}
+
+template<typename T, size_t R, size_t C, typename TI>
+std::enable_if_t<R != DynamicExtent && C != DynamicExtent && !IsMatrix<TI>::value, Matrix<T, R, C>>
+operator*(const Matrix<T, R, C>& l, const TI& r) {
+    Matrix<T, R, C> res = l;
+    res *= r;
+    return res;
+}
+
+template<typename T, size_t R, size_t C, typename TI>
+std::enable_if_t<R != DynamicExtent && C != DynamicExtent && !IsMatrix<TI>::value, Matrix<T, R, C>>
+operator*(const TI& l, const Matrix<T, R, C>& r) {
+    Matrix<T, R, C> res = r;
+    res *= l;
+    return res;
+}
+
+template<typename T, size_t R, size_t C>
+Matrix<T, R, C>& Matrix<T, R, C>::transpose() {
+    static_assert(R == C, "in-place transpose needs a square matrix, use transposed()");
+    for (size_t i = 0; i != R; ++i)
+        for (size_t j = i + 1; j != C; ++j)
+            std::swap(m[i][j], m[j][i]);
+    return *this;
+}
+
+template<typename T, size_t R, size_t C>
+Matrix<T, C, R> Matrix<T, R, C>::transposed() const {
+    Matrix<T, C, R> res;
+    for (size_t i = 0; i != R; ++i)
+        for (size_t j = 0; j != C; ++j)
+            res(j, i) = m[i][j];
+    return res;
+}
+
+template<typename T, size_t R, size_t C>
+Matrix<T, R, C> Matrix<T, R, C>::inverse() const {
+    static_assert(R == C, "only square matrices have an inverse");
+    T s[R][2 * R];
+    for (size_t i = 0; i != R; ++i)
+        for (size_t j = 0; j != R; ++j) {
+            s[i][j] = m[i][j];
+            s[i][R + j] = (i == j ? T(1) : T(0));
+        }
+
+    using std::abs;
+    for (size_t j = 0; j != R; ++j) {
+        size_t maxi = j;
+        for (size_t i = j + 1; i != R; ++i)
+            if (abs(s[i][j]) > abs(s[maxi][j]))
+                maxi = i;
+        if (maxi != j)
+            for (size_t k = 0; k != 2 * R; ++k)
+                std::swap(s[j][k], s[maxi][k]);
+        T d = T(1) / s[j][j];
+        for (size_t k = 0; k != 2 * R; ++k)
+            s[j][k] *= d;
+        for (size_t i = 0; i != R; ++i) {
+            if (i == j)
+                continue;
+            T f = s[i][j];
+            for (size_t k = 0; k != 2 * R; ++k)
+                s[i][k] -= s[j][k] * f;
+        }
+    }
+
+    Matrix<T, R, C> res;
+    for (size_t i = 0; i != R; ++i)
+        for (size_t j = 0; j != R; ++j)
+            res(i, j) = s[i][R + j];
+    return res;
+}
+
+template<typename T, size_t R, size_t C>
+template<typename U>
+std::array<U, R> Matrix<T, R, C>::solve(const std::array<U, R>& b) const {
+    static_assert(R == C, "solve needs a square matrix");
+    U s[R][R + 1];
+    for (size_t i = 0; i != R; ++i) {
+        for (size_t j = 0; j != R; ++j)
             s[i][j] = static_cast<U>(m[i][j]);
-    for (size_t i = 0; i < b.size(); ++i)
-        s[i].push_back(b[i]);
+        s[i][R] = b[i];
+    }
 
-    for (size_t j = 0; j < s.size(); ++j) {
+    using std::abs;
+    for (size_t j = 0; j != R; ++j) {
         size_t maxi = j;
-        for (size_t i = j + 1; i < s.size(); ++i)
-            if (std::abs(s[i][j]) > std::abs(s[maxi][j]))
+        for (size_t i = j + 1; i != R; ++i)
+            if (abs(s[i][j]) > abs(s[maxi][j]))
                 maxi = i;
-        std::swap(s[j], s[maxi]);
-        for (size_t i = 0; i < s.size(); ++i) {
+        if (maxi != j)
+            for (size_t k = j; k <= R; ++k)
+                std::swap(s[j][k], s[maxi][k]);
+        for (size_t i = 0; i != R; ++i) {
             if (i == j)
                 continue;
             U d = s[i][j] / s[j][j];
-            for (size_t k = j; k <= s.size(); ++k)
+            for (size_t k = j; k <= R; ++k)
                 s[i][k] -= s[j][k] * d;
         }
     }
 
-    std::vector<U> ans(s.size());
-    for (size_t i = 0; i < s.size(); ++i)
-        ans[i] = s[i][s.size()] / s[i][i];
+    std::array<U, R> ans;
+    for (size_t i = 0; i != R; ++i)
+        ans[i] = s[i][R] / s[i][i];
     return ans;
-}
\ No newline at end of file
+}
+
+template<typename T, size_t R, size_t C>
+template<typename U>
+std::vector<U> Matrix<T, R, C>::solve(const std::vector<U>& b) const {
+    CheckSolveShape(R, C, b.size());
+    std::array<U, R> a;
+    std::copy(b.begin(), b.end(), a.begin());
+    a = solve(a);
+    return std::vector<U>(a.begin(), a.end());
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <stdexcept>
+
+#include "matrix.cpp"
+
+// Many same-shaped matrices stored interleaved across the batch: element (i, j)
+// of every matrix forms one contiguous plane, so each operation runs its
+// innermost loop over the batch, which vectorizes, and splits the batch
+// between threads.
+template<typename T>
+class MatrixBatch {
+private:
+    size_t count, rows, cols;
+    std::vector<T> data;
+
+    T* plane(size_t i, size_t j) {
+        return data.data() + (i * cols + j) * count;
+    }
+
+    const T* plane(size_t i, size_t j) const {
+        return data.data() + (i * cols + j) * count;
+    }
+
+    void check_count(const MatrixBatch& other) const {
+        if (count != other.count)
+            throw std::invalid_argument("batches have different sizes");
+    }
+
+    // Calls f(lo, hi) on disjoint lane ranges of at most tile lanes, so the
+    // planes touched by one call stay in cache. Ranges are spread over threads
+    // once the batch is large enough to pay for them.
+    template<typename F>
+    void for_lanes(size_t work_per_lane, F f) const {
+        const size_t tile = 256;
+        auto run = [&f, tile](size_t lo, size_t hi) {
+            for (size_t t = lo; t < hi; t += tile)
+                f(t, std::min(hi, t + tile));
+        };
+        size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, count * work_per_lane / (1 << 16) + 1);
+        if (threads <= 1) {
+            run(size_t(0), count);
+            return;
+        }
+        size_t chunk = ((count + threads - 1) / threads + tile - 1) / tile * tile;
+        std::vector<std::thread> pool;
+        for (size_t lo = chunk; lo < count; lo += chunk)
+            pool.emplace_back(run, lo, std::min(count, lo + chunk));
+        run(size_t(0), std::min(count, chunk));
+        for (size_t t = 0; t < pool.size(); ++t)
+            pool[t].join();
+    }
+
+public:
+    MatrixBatch(size_t n, size_t r, size_t c)
+        : count(n), rows(r), cols(c), data(n * r * c, T()) { }
+
+    MatrixBatch(const std::vector<Matrix<T>>& v)
+        : count(v.size()),
+          rows(v.empty() ? 0 : v[0].size().first),
+          cols(v.empty() ? 0 : v[0].size().second),
+          data(count * rows * cols) {
+        for (size_t b = 0; b < count; ++b)
+            if (v[b].size() != std::make_pair(rows, cols))
+                throw std::invalid_argument("matrices in a batch must have the same dimensions");
+        for (size_t b = 0; b < count; ++b)
+            for (size_t i = 0; i < rows; ++i)
+                for (size_t j = 0; j < cols; ++j)
+                    plane(i, j)[b] = v[b](i, j);
+    }
+
+    std::vector<Matrix<T>> matrices() const {
+        std::vector<Matrix<T>> res;
+        res.reserve(count);
+        for (size_t b = 0; b < count; ++b) {
+            std::vector<std::vector<T>> m(rows, std::vector<T>(cols));
+            for (size_t i = 0; i < rows; ++i)
+                for (size_t j = 0; j < cols; ++j)
+                    m[i][j] = plane(i, j)[b];
+            res.emplace_back(m);
+        }
+        return res;
+    }
+
+    size_t batch_size() const {
+        return count;
+    }
+
+    std::pair<size_t, size_t> size() const {
+        return {rows, cols};
+    }
+
+    const T& operator()(size_t b, size_t i, size_t j) const {
+        return plane(i, j)[b];
+    }
+
+    T& operator()(size_t b, size_t i, size_t j) {
+        return plane(i, j)[b];
+    }
+
+    MatrixBatch& operator+=(const MatrixBatch& other);
+
+    MatrixBatch& operator*=(const MatrixBatch& other);
+
+    static MatrixBatch product(const MatrixBatch& l, const MatrixBatch& r);
+
+    MatrixBatch& transpose();
+
+    MatrixBatch transposed() const;
+
+    MatrixBatch solve(const MatrixBatch& b) const;
+};
+
+template<typename T>
+MatrixBatch<T>& MatrixBatch<T>::operator+=(const MatrixBatch<T>& other) {
+    check_count(other);
+    if (size() != other.size())
+        throw std::invalid_argument("matrix sizes do not match");
+    for_lanes(rows * cols, [&](size_t lo, size_t hi) {
+        for (size_t e = 0; e < rows * cols; ++e) {
+            T* l = data.data() + e * count;
+            const T* r = other.data.data() + e * count;
+            for (size_t b = lo; b < hi; ++b)
+                l[b] += r[b];
+        }
+    });
+    return *this;
+}
+
+template<typename T>
+MatrixBatch<T> MatrixBatch<T>::product(const MatrixBatch<T>& l, const MatrixBatch<T>& r) {
+    l.check_count(r);
+    if (l.cols != r.rows)
+        throw std::invalid_argument("matrix sizes do not match");
+    MatrixBatch<T> res(l.count, l.rows, r.cols);
+    l.for_lanes(l.rows * l.cols * r.cols, [&](size_t lo, size_t hi) {
+        for (size_t i = 0; i < l.rows; ++i)
+            for (size_t k = 0; k < l.cols; ++k) {
+                const T* a = l.plane(i, k);
+                for (size_t j = 0; j < r.cols; ++j) {
+                    const T* o = r.plane(k, j);
+                    T* d = res.plane(i, j);
+                    for (size_t b = lo; b < hi; ++b)
+                        d[b] += a[b] * o[b];
+                }
+            }
+    });
+    return res;
+}
+
+template<typename T>
+MatrixBatch<T>& MatrixBatch<T>::operator*=(const MatrixBatch<T>& other) {
+    *this = product(*this, other);
+    return *this;
+}
+
+template<typename T>
+MatrixBatch<T> operator+(const MatrixBatch<T>& l, const MatrixBatch<T>& r) {
+    MatrixBatch<T> res = l;
+    res += r;
+    return res;
+}
+
+template<typename T>
+MatrixBatch<T> operator*(const MatrixBatch<T>& l, const MatrixBatch<T>& r) {
+    return MatrixBatch<T>::product(l, r);
+}
+
+template<typename T>
+MatrixBatch<T>& MatrixBatch<T>::transpose() {
+    *this = transposed();
+    return *this;
+}
+
+template<typename T>
+MatrixBatch<T> MatrixBatch<T>::transposed() const {
+    MatrixBatch<T> res(count, cols, rows);
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < cols; ++j)
+            std::copy(plane(i, j), plane(i, j) + count, res.plane(j, i));
+    return res;
+}
+
+// Gauss-Jordan elimination with partial pivoting, one system per lane. Pivot
+// rows differ between lanes, so row swaps are done lane by lane; elimination
+// itself runs across the batch.
+template<typename T>
+MatrixBatch<T> MatrixBatch<T>::solve(const MatrixBatch<T>& b) const {
+    check_count(b);
+    if (rows != cols)
+        throw std::invalid_argument("solve needs square matrices");
+    if (b.rows != rows)
+        throw std::invalid_argument("right-hand side size does not match the matrix");
+    size_t n = rows, k = b.cols;
+    MatrixBatch<T> s(count, n, n + k);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j)
+            std::copy(plane(i, j), plane(i, j) + count, s.plane(i, j));
+        for (size_t j = 0; j < k; ++j)
+            std::copy(b.plane(i, j), b.plane(i, j) + count, s.plane(i, n + j));
+    }
+
+    for_lanes(n * n * (n + k), [&](size_t lo, size_t hi) {
+        std::vector<T> f(hi - lo);
+        using std::abs;
+        for (size_t j = 0; j < n; ++j) {
+            for (size_t lane = lo; lane < hi; ++lane) {
+                size_t maxi = j;
+                for (size_t i = j + 1; i < n; ++i)
+                    if (abs(s.plane(i, j)[lane]) > abs(s.plane(maxi, j)[lane]))
+                        maxi = i;
+                if (maxi != j)
+                    for (size_t c = j; c < n + k; ++c)
+                        std::swap(s.plane(j, c)[lane], s.plane(maxi, c)[lane]);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                if (i == j)
+                    continue;
+                const T* fi = s.plane(i, j);
+                const T* pj = s.plane(j, j);
+                for (size_t lane = lo; lane < hi; ++lane)
+                    f[lane - lo] = fi[lane] / pj[lane];
+                for (size_t c = j; c < n + k; ++c) {
+                    T* dst = s.plane(i, c) + lo;
+                    const T* src = s.plane(j, c) + lo;
+                    for (size_t lane = 0; lane < hi - lo; ++lane)
+                        dst[lane] -= src[lane] * f[lane];
+                }
+            }
+        }
+    });
+
+    MatrixBatch<T> res(count, n, k);
+    for_lanes(n * k, [&](size_t lo, size_t hi) {
+        for (size_t i = 0; i < n; ++i) {
+            const T* d = s.plane(i, i);
+            for (size_t j = 0; j < k; ++j) {
+                const T* src = s.plane(i, n + j);
+                T* dst = res.plane(i, j);
+                for (size_t lane = lo; lane < hi; ++lane)
+                    dst[lane] = src[lane] / d[lane];
+            }
+        }
+    });
+    return res;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "matrix.cpp"
+#include "serialization.cpp"
+
+template<typename T>
+void WriteMatrix(std::ostream& out, const Matrix<T>& m) {
+    size_t n = m.size().first * m.size().second;
+    WriteHeader(out, MakeHeader<T>(BinaryKind::Matrix, m.size().first, m.size().second, n * sizeof(T)));
+    WriteArray(out, m.view().ptr(), n);
+}
+
+template<typename T>
+Matrix<T> ReadMatrix(std::istream& in) {
+    BinaryHeader h = ReadHeader<T>(in, BinaryKind::Matrix);
+    return Matrix<T>(h.rows, h.cols, ArrayBuffer<T>(ReadArray<T>(in, h.rows * h.cols)));
+}
+
+// The result reads straight from the mapping, which stays alive as long as
+// the matrix or any copy of it refers to it; the first write copies the data.
+template<typename T>
+Matrix<T> MapMatrix(const std::string& path) {
+    IntrusivePtr<MappedFile> file(new MappedFile(path));
+    const BinaryHeader& h = file->header<T>(BinaryKind::Matrix);
+    return Matrix<T>(h.rows, h.cols, file->array<T>(h.payload, h.rows * h.cols));
+}
+
+// Reads the text written by operator<<: rows separated by newlines, elements
+// by tabs.
+template<typename T>
+Matrix<T> ParseMatrix(std::istream& in) {
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const char* s = text.data();
+    const char* end = s + text.size();
+    std::vector<T> v;
+    size_t rows = 0, cols = 0;
+    while (s != end) {
+        size_t n = 0;
+        while (s != end && *s != '\n') {
+            v.push_back(ParseValue<T>(s, end));
+            ++n;
+            while (s != end && (*s == '\t' || *s == ' ' || *s == '\r'))
+                ++s;
+        }
+        if (s != end)
+            ++s;
+        if (!n)
+            continue;
+        if (rows && n != cols)
+            throw std::runtime_error("rows of different length");
+        cols = n;
+        ++rows;
+    }
+    return Matrix<T>(rows, cols, ArrayBuffer<T>(std::move(v)));
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <stdexcept>
+
+#include "matrix.cpp"
+
+// p(a) for a square a and a polynomial of either implementation (anything
+// with Degree() and operator[]), by the Paterson-Stockmeyer scheme. The
+// powers a^2 .. a^k are formed once and
+//   p(a) = sum over j of B_j (a^k)^j,  B_j = sum over i < k of p[j k + i] a^i,
+// is evaluated by Horner's rule in a^k. That takes k - 1 + d / k matrix
+// products for degree d, about 2 sqrt(d) with the best k, against d for
+// Horner's rule in a; forming the B_j only needs scalar multiply-adds.
+template<typename Poly, typename T>
+Matrix<T> PolynomialOfMatrix(const Poly& p, const Matrix<T>& a) {
+    if (a.size().first != a.size().second)
+        throw std::invalid_argument("a polynomial of a matrix needs a square matrix");
+    HSE_SCOPED_OP("matrix.polynomial");
+    size_t n = a.size().first;
+    int deg = p.Degree();
+    if (deg < 0)
+        return Matrix<T>(n, n);
+    size_t d = deg, k = 1;
+    for (size_t c = 2; c <= d; ++c)
+        if (c - 1 + d / c < k - 1 + d / k)
+            k = c;
+
+    std::vector<Matrix<T>> pw;
+    pw.reserve(k + 1);
+    pw.push_back(Matrix<T>(0, 0));  // a^0 is added to the diagonal directly
+    pw.push_back(a);
+    for (size_t i = 2; i <= k && i <= d; ++i)
+        pw.push_back(pw.back() * a);
+
+    auto block = [&](size_t j) {
+        std::vector<T> out(n * n, T());
+        for (size_t i = 0; i < k && j * k + i <= d; ++i) {
+            T c = p[j * k + i];
+            if (c == T())
+                continue;
+            if (i == 0) {
+                for (size_t r = 0; r < n; ++r)
+                    out[r * n + r] += c;
+                continue;
+            }
+            const T* src = std::as_const(pw[i]).view().ptr();
+            for (size_t e = 0; e < n * n; ++e)
+                out[e] += c * src[e];
+        }
+        return Matrix<T>(n, n, ArrayBuffer<T>(std::move(out)));
+    };
+
+    Matrix<T> res = block(d / k);
+    for (size_t j = d / k; j-- > 0;) {
+        res *= pw[k];
+        res += block(j);
+    }
+    return res;
+}
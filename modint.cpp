@@ -0,0 +1,427 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+// The AVX2 kernel is compiled in whenever the compiler can target AVX2. With
+// AVX2 enabled for the whole build (e.g. HSE_NATIVE_ARCH) it is called
+// directly; otherwise, with GCC or Clang on x86, it is built for AVX2 alone
+// and picked at run time if the CPU supports it.
+#if defined(__AVX2__)
+#define HSE_AVX2_KERNEL 1
+#define HSE_TARGET_AVX2
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define HSE_AVX2_KERNEL 1
+#define HSE_AVX2_DISPATCH 1
+#define HSE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(HSE_AVX2_KERNEL)
+#include <immintrin.h>
+#endif
+
+#include "field.cpp"
+
+// Montgomery constants for an odd modulus below 2^30. A residue x is stored
+// as x * 2^32 mod m, which turns modular multiplication into two 32x32->64
+// multiplies and a shift instead of a 64-bit division.
+class Montgomery {
+private:
+    static constexpr uint32_t NegInverse(uint32_t m) {
+        uint32_t x = m;
+        for (int i = 0; i < 5; ++i)
+            x *= 2 - m * x;
+        return 0 - x;
+    }
+
+public:
+    uint32_t mod;
+    uint32_t inv;  // -mod^-1 mod 2^32
+    uint32_t r2;   // 2^64 mod mod
+
+    constexpr explicit Montgomery(uint32_t m)
+        : mod(m), inv(NegInverse(m)), r2(static_cast<uint32_t>((0 - static_cast<uint64_t>(m)) % m)) { }
+
+    // x < mod * 2^32; the result is congruent to x / 2^32 and below 2 * mod.
+    constexpr uint32_t reduce_lazy(uint64_t x) const {
+        uint32_t q = static_cast<uint32_t>(x) * inv;
+        return static_cast<uint32_t>((x + static_cast<uint64_t>(q) * mod) >> 32);
+    }
+
+    constexpr uint32_t reduce(uint64_t x) const {
+        uint32_t t = reduce_lazy(x);
+        return t >= mod ? t - mod : t;
+    }
+};
+
+constexpr bool IsPrime(uint32_t m) {
+    if (m < 2)
+        return false;
+    for (uint32_t d = 2; d * d <= m; ++d)
+        if (m % d == 0)
+            return false;
+    return true;
+}
+
+// Integer modulo P. P = 0 selects a modulus chosen at run time through
+// set_modulus(), shared by all ModInt<0> values; it must be set before any
+// value is created and not changed while values are alive.
+template<uint32_t P>
+class ModInt {
+    static_assert(P == 0 || (P % 2 == 1 && P > 1 && P < (1u << 30)),
+                  "Montgomery reduction needs an odd modulus below 2^30");
+
+private:
+    uint32_t v;
+
+    static Montgomery& runtime() {
+        static Montgomery m(1);
+        return m;
+    }
+
+    static bool& runtime_prime() {
+        static bool prime = false;
+        return prime;
+    }
+
+public:
+    static const Montgomery& params() {
+        if constexpr (P != 0) {
+            static constexpr Montgomery m(P);
+            return m;
+        } else {
+            return runtime();
+        }
+    }
+
+    static uint32_t modulus() {
+        return params().mod;
+    }
+
+    static bool prime_modulus() {
+        if constexpr (P != 0) {
+            static constexpr bool prime = IsPrime(P);
+            return prime;
+        } else {
+            return runtime_prime();
+        }
+    }
+
+    static void set_modulus(uint32_t m) {
+        static_assert(P == 0, "the modulus of ModInt<P> is fixed at compile time");
+        if (m % 2 == 0 || m < 3 || m >= (1u << 30))
+            throw std::invalid_argument("ModInt modulus must be odd and below 2^30");
+        runtime() = Montgomery(m);
+        runtime_prime() = IsPrime(m);
+    }
+
+    ModInt(long long x = 0) {
+        const Montgomery& m = params();
+        long long r = x % static_cast<long long>(m.mod);
+        if (r < 0)
+            r += m.mod;
+        v = m.reduce(static_cast<uint64_t>(r) * m.r2);
+    }
+
+    // The internal representation, for kernels working on raw arrays.
+    static ModInt from_montgomery(uint32_t x) {
+        ModInt res;
+        res.v = x;
+        return res;
+    }
+
+    uint32_t montgomery() const {
+        return v;
+    }
+
+    uint32_t value() const {
+        return params().reduce(v);
+    }
+
+    bool operator==(const ModInt& other) const {
+        return v == other.v;
+    }
+
+    bool operator!=(const ModInt& other) const {
+        return v != other.v;
+    }
+
+    // Ordering by representative in [0, P): meaningless algebraically, but
+    // lets residues sit in ordered containers and be printed with signs.
+    bool operator<(const ModInt& other) const {
+        return value() < other.value();
+    }
+
+    bool operator>(const ModInt& other) const {
+        return other < *this;
+    }
+
+    ModInt operator-() const {
+        return from_montgomery(v == 0 ? 0 : params().mod - v);
+    }
+
+    ModInt& operator+=(const ModInt& other) {
+        v += other.v;
+        if (v >= params().mod)
+            v -= params().mod;
+        return *this;
+    }
+
+    ModInt& operator-=(const ModInt& other) {
+        v += params().mod - other.v;
+        if (v >= params().mod)
+            v -= params().mod;
+        return *this;
+    }
+
+    ModInt& operator*=(const ModInt& other) {
+        v = params().reduce(static_cast<uint64_t>(v) * other.v);
+        return *this;
+    }
+
+    ModInt& operator/=(const ModInt& other) {
+        return *this *= other.inverse();
+    }
+
+    // Extended Euclid on the representative; works for any modulus as long
+    // as the value is coprime to it.
+    ModInt inverse() const {
+        long long a = value(), b = modulus(), x = 1, y = 0;
+        while (b != 0) {
+            long long q = a / b;
+            a -= q * b;
+            std::swap(a, b);
+            x -= q * y;
+            std::swap(x, y);
+        }
+        if (a != 1)
+            throw std::domain_error("ModInt value is not invertible");
+        return ModInt(x);
+    }
+
+    ModInt pow(uint64_t e) const {
+        ModInt res = 1, a = *this;
+        for (; e; e >>= 1) {
+            if (e & 1)
+                res *= a;
+            a *= a;
+        }
+        return res;
+    }
+
+    friend ModInt operator+(ModInt l, const ModInt& r) {
+        return l += r;
+    }
+
+    friend ModInt operator-(ModInt l, const ModInt& r) {
+        return l -= r;
+    }
+
+    friend ModInt operator*(ModInt l, const ModInt& r) {
+        return l *= r;
+    }
+
+    friend ModInt operator/(ModInt l, const ModInt& r) {
+        return l /= r;
+    }
+
+    // Pivot selection only needs "nonzero beats zero", which the
+    // representative provides.
+    friend uint32_t abs(const ModInt& x) {
+        return x.value();
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const ModInt& x) {
+        return out << x.value();
+    }
+
+    friend std::istream& operator>>(std::istream& in, ModInt& x) {
+        long long t;
+        if (in >> t)
+            x = ModInt(t);
+        return in;
+    }
+};
+
+using DynamicModInt = ModInt<0>;
+
+template<uint32_t P>
+class FieldTraits<ModInt<P>> {
+public:
+    static bool is_field() {
+        return ModInt<P>::prime_modulus();
+    }
+};
+
+// Sum of reduce_lazy(a[i] * b[i]) for i in [from, n), scalar.
+inline uint64_t MontgomeryDotTail(const uint32_t* a, const uint32_t* b, size_t from, size_t n, const Montgomery& m) {
+    uint64_t sum = 0;
+    for (size_t i = from; i < n; ++i)
+        sum += m.reduce_lazy(static_cast<uint64_t>(a[i]) * b[i]);
+    return sum;
+}
+
+#if defined(HSE_AVX2_KERNEL)
+// reduce_lazy of the products of the even 32-bit lanes of x and y.
+HSE_TARGET_AVX2 inline __m256i MontgomeryLanes(__m256i x, __m256i y, __m256i inv, __m256i mod) {
+    __m256i t = _mm256_mul_epu32(x, y);
+    __m256i q = _mm256_mul_epu32(t, inv);
+    t = _mm256_add_epi64(t, _mm256_mul_epu32(q, mod));
+    return _mm256_srli_epi64(t, 32);
+}
+
+HSE_TARGET_AVX2 inline uint64_t MontgomeryDotAvx2(const uint32_t* a, const uint32_t* b, size_t n, const Montgomery& m) {
+    const __m256i inv = _mm256_set1_epi64x(m.inv);
+    const __m256i mod = _mm256_set1_epi64x(m.mod);
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        acc = _mm256_add_epi64(acc, MontgomeryLanes(x, y, inv, mod));
+        acc = _mm256_add_epi64(acc, MontgomeryLanes(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32), inv, mod));
+    }
+    alignas(32) uint64_t part[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(part), acc);
+    return part[0] + part[1] + part[2] + part[3] + MontgomeryDotTail(a, b, i, n, m);
+}
+#endif
+
+// Sum of reduce_lazy(a[i] * b[i]) over Montgomery-form inputs below mod.
+// Every term is below 2 * mod < 2^31, so the 64-bit total cannot overflow
+// and is reduced once by the caller.
+inline uint64_t MontgomeryDot(const uint32_t* a, const uint32_t* b, size_t n, const Montgomery& m) {
+#if defined(HSE_AVX2_DISPATCH)
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2)
+        return MontgomeryDotAvx2(a, b, n, m);
+#elif defined(HSE_AVX2_KERNEL)
+    return MontgomeryDotAvx2(a, b, n, m);
+#endif
+    return MontgomeryDotTail(a, b, 0, n, m);
+}
+
+template<uint32_t P>
+const uint32_t* MontgomeryData(const ModInt<P>* p) {
+    static_assert(sizeof(ModInt<P>) == sizeof(uint32_t), "ModInt must be a bare residue");
+    return reinterpret_cast<const uint32_t*>(p);
+}
+
+template<uint32_t P>
+ModInt<P> DotProduct(const ModInt<P>* a, const ModInt<P>* b, size_t n) {
+    const Montgomery& m = ModInt<P>::params();
+    uint64_t sum = MontgomeryDot(MontgomeryData(a), MontgomeryData(b), n, m);
+    return ModInt<P>::from_montgomery(static_cast<uint32_t>(sum % m.mod));
+}
+
+// The overloads below are picked up by argument-dependent lookup from the
+// generic Convolve, EvaluatePolynomial, MultiplyInto and SolveSystem when the
+// element type is a ModInt, replacing their per-element reductions with the
+// batch kernels above.
+
+// res (n + m - 1 elements) += a * b. Each output coefficient is one dot
+// product of a against b reversed, so both operands are read contiguously.
+template<uint32_t P>
+void Convolve(ModInt<P>* res, const ModInt<P>* a, size_t n, const ModInt<P>* b, size_t m) {
+    if (n == 0 || m == 0)
+        return;
+    const Montgomery& mg = ModInt<P>::params();
+    std::vector<uint32_t> rb(m);
+    for (size_t j = 0; j < m; ++j)
+        rb[j] = b[m - 1 - j].montgomery();
+    const uint32_t* pa = MontgomeryData(a);
+    for (size_t k = 0; k + 1 < n + m; ++k) {
+        size_t lo = k < m ? 0 : k - (m - 1), hi = std::min(k, n - 1);
+        uint64_t sum = MontgomeryDot(pa + lo, rb.data() + (m - 1 - k + lo), hi - lo + 1, mg);
+        res[k] += ModInt<P>::from_montgomery(static_cast<uint32_t>(sum % mg.mod));
+    }
+}
+
+// Blocked Horner scheme: x^0 .. x^(B-1) are computed once, each block of B
+// coefficients is a dot product against them, and blocks are combined with
+// Horner steps in x^B.
+template<uint32_t P>
+ModInt<P> EvaluatePolynomial(const ModInt<P>* c, size_t n, const ModInt<P>& x) {
+    const size_t block = 64;
+    size_t len = std::min(n, block);
+    ModInt<P> pw[block];
+    ModInt<P> cur = 1;
+    for (size_t i = 0; i < len; ++i) {
+        pw[i] = cur;
+        cur *= x;
+    }
+    ModInt<P> res = 0;
+    for (size_t hi = n; hi > 0;) {
+        size_t lo = (hi - 1) / block * block;
+        res = res * cur + DotProduct(c + lo, pw, hi - lo);
+        hi = lo;
+    }
+    return res;
+}
+
+template<typename T>
+class MatrixView;
+
+// res (l.rows x r.cols, row-major, zero-filled) += l * r, as dot products of
+// rows of l against columns of r, both copied out contiguously first.
+template<uint32_t P, typename L, typename R>
+void MultiplyInto(ModInt<P>* res, const MatrixView<L>& l, const MatrixView<R>& r) {
+    size_t rows = l.size().first, inner = l.size().second, cols = r.size().second;
+    const Montgomery& m = ModInt<P>::params();
+    std::vector<uint32_t> rt(cols * inner), row(inner);
+    for (size_t k = 0; k != inner; ++k)
+        for (size_t j = 0; j != cols; ++j)
+            rt[j * inner + k] = r(k, j).montgomery();
+    for (size_t i = 0; i != rows; ++i) {
+        for (size_t k = 0; k != inner; ++k)
+            row[k] = l(i, k).montgomery();
+        ModInt<P>* out = res + i * cols;
+        for (size_t j = 0; j != cols; ++j) {
+            uint64_t sum = MontgomeryDot(row.data(), rt.data() + j * inner, inner, m);
+            out[j] += ModInt<P>::from_montgomery(static_cast<uint32_t>(sum % m.mod));
+        }
+    }
+}
+
+// Gauss-Jordan elimination over the field: any nonzero pivot is exact, so
+// the first one is taken, and each pivot row is scaled by one inverse instead
+// of dividing every eliminated entry. A singular system throws from inverse().
+template<uint32_t P, typename T>
+std::vector<ModInt<P>> SolveSystem(const MatrixView<T>& a, const std::vector<ModInt<P>>& b) {
+    size_t n = a.size().first;
+    std::vector<ModInt<P>> buf(n * (n + 1));
+    std::vector<ModInt<P>*> s(n);
+    for (size_t i = 0; i < n; ++i) {
+        s[i] = buf.data() + i * (n + 1);
+        for (size_t j = 0; j < n; ++j)
+            s[i][j] = static_cast<ModInt<P>>(a(i, j));
+        s[i][n] = b[i];
+    }
+
+    for (size_t j = 0; j < n; ++j) {
+        size_t piv = j;
+        while (piv + 1 < n && s[piv][j] == ModInt<P>())
+            ++piv;
+        std::swap(s[j], s[piv]);
+        ModInt<P> d = s[j][j].inverse();
+        for (size_t k = j; k <= n; ++k)
+            s[j][k] *= d;
+        for (size_t i = 0; i < n; ++i) {
+            if (i == j || s[i][j] == ModInt<P>())
+                continue;
+            ModInt<P> f = s[i][j];
+            for (size_t k = j; k <= n; ++k)
+                s[i][k] -= s[j][k] * f;
+        }
+    }
+
+    std::vector<ModInt<P>> ans(n);
+    for (size_t i = 0; i < n; ++i)
+        ans[i] = s[i][n];
+    return ans;
+}
@@ -1,42 +1,93 @@
+#pragma once
+
 #include <iostream>
 #include <vector>
 #include <utility>
 #include <algorithm>
+#include <type_traits>
+#include <complex>
+#include <cmath>
+
+#include "cow.cpp"
+#include "field.cpp"
+#include "instrumentation.cpp"
+
+// Inner kernels of multiplication and evaluation. They are called unqualified,
+// so coefficient types with faster arithmetic (see modint.cpp) can supply
+// overloads found by argument-dependent lookup.
+
+// res (n + m - 1 elements) += a * b.
+template<typename T>
+void Convolve(T* res, const T* a, size_t n, const T* b, size_t m) {
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < m; ++j)
+            res[i + j] += a[i] * b[j];
+}
+
+template<typename T>
+T EvaluatePolynomial(const T* c, size_t n, const T& x) {
+    T cur = T(1), res = T();
+    for (size_t i = 0; i < n; ++i) {
+        res += cur * c[i];
+        cur *= x;
+    }
+    return res;
+}
 
 template<typename T>
 class Polynomial {
 private:
-    std::vector<T> p;
+    Cow<ArrayBuffer<T>> p;
+
+    // Unshares the coefficients before a write; this is where copies of a
+    // Polynomial actually allocate.
+    std::vector<T>& storage() {
+#ifdef HSE_INSTRUMENT
+        if (p.shared() || p.read().borrowed())
+            HSE_COUNT_ALLOC("polynomial_dense.copy", p.read().size() * sizeof(T));
+#endif
+        return p.write().vec();
+    }
 
     void cut() {
-        while (p.size() && p.back() == T())
-            p.pop_back();
+        if (p.read().empty() || p.read().back() != T())
+            return;
+        std::vector<T>& v = storage();
+        while (v.size() && v.back() == T())
+            v.pop_back();
     }
 
+    // 1 / (k h0) for 1 <= k < len with a single division (prefix products
+    // walked back), or false if some k is zero in T.
+    static bool miller_inverses(size_t len, const T& h0, std::vector<T>& inv);
+
 public:
     Polynomial() { }
 
-    Polynomial(std::vector<T> v) : p(v) {
+    Polynomial(std::vector<T> v) : p(ArrayBuffer<T>(std::move(v))) {
         cut();
     }
 
     Polynomial(const T& k) {
-        p = {k};
-        cut();
+        if (k != T())
+            p = ArrayBuffer<T>(std::vector<T>{k});
     }
 
     template<typename Iter>
-    Polynomial(Iter begin, Iter end) {
-        std::copy(begin, end, std::back_inserter(p));
+    Polynomial(Iter begin, Iter end) : p(ArrayBuffer<T>(std::vector<T>(begin, end))) {
         cut();
     }
 
-    typename std::vector<T>::const_iterator begin() const {
-        return p.cbegin();
+    Polynomial(ArrayBuffer<T> coefficients) : p(std::move(coefficients)) {
+        cut();
     }
 
-    typename std::vector<T>::const_iterator end() const {
-        return p.cend();
+    const T* begin() const {
+        return p.read().begin();
+    }
+
+    const T* end() const {
+        return p.read().end();
     }
 
     int Degree() const;
@@ -53,11 +104,21 @@ public:
 
     Polynomial& operator*=(const Polynomial& other);
 
-    Polynomial operator+(const Polynomial& other) const;
+    Polynomial operator+(const Polynomial& other) const&;
+
+    Polynomial operator+(const Polynomial& other) &&;
+
+    Polynomial operator+(Polynomial&& other) const&;
 
-    Polynomial operator-(const Polynomial& other) const;
+    Polynomial operator+(Polynomial&& other) &&;
 
-    Polynomial operator*(const Polynomial& other) const;
+    Polynomial operator-(const Polynomial& other) const&;
+
+    Polynomial operator-(const Polynomial& other) &&;
+
+    Polynomial operator*(const Polynomial& other) const&;
+
+    Polynomial operator*(const Polynomial& other) &&;
 
     Polynomial operator&(const Polynomial& other) const;
 
@@ -68,22 +129,29 @@ public:
     Polynomial operator,(const Polynomial& other) const;
 
     T operator()(T v) const;
+
+    Polynomial pow(size_t n) const;
+
+    Polynomial pow_fft(size_t n) const;
 };
 
 template<typename T>
 int Polynomial<T>::Degree() const {
-    return static_cast<int>(p.size()) - 1;
+    return static_cast<int>(p.read().size()) - 1;
 }
 
 template<typename T>
 T Polynomial<T>::operator[](size_t i) const {
-    return (i >= p.size() ? T() : p[i]);
+    const ArrayBuffer<T>& v = p.read();
+    return (i >= v.size() ? T() : v[i]);
 }
 
 template<typename T>
 bool Polynomial<T>::operator==(const Polynomial<T>& other) const {
-    return (p.size() == other.p.size()) &&
-           (std::equal(std::begin(p), std::end(p), std::begin(other.p)));
+    const ArrayBuffer<T>& a = p.read();
+    const ArrayBuffer<T>& b = other.p.read();
+    return (a.size() == b.size()) &&
+           (std::equal(std::begin(a), std::end(a), std::begin(b)));
 }
 
 template<typename T>
@@ -93,63 +161,107 @@ bool Polynomial<T>::operator!=(const Polynomial<T>& other) const {
 
 template<typename T>
 Polynomial<T>& Polynomial<T>::operator+=(const Polynomial<T>& other) {
-    if (p.size() < other.p.size())
-        p.resize(other.p.size());
-    for (size_t i = 0; i < std::min(p.size(), other.p.size()); ++i)
-        p[i] += other.p[i];
+    HSE_SCOPED_OP("polynomial_dense.add");
+    HSE_COUNT_FLOPS("polynomial_dense.add", other.p.read().size());
+    Cow<ArrayBuffer<T>> keep = other.p;
+    const ArrayBuffer<T>& o = keep.read();
+    std::vector<T>& v = storage();
+    if (v.size() < o.size())
+        v.resize(o.size());
+    for (size_t i = 0; i < o.size(); ++i)
+        v[i] += o[i];
     cut();
     return *this;
 }
 
 template<typename T>
 Polynomial<T>& Polynomial<T>::operator-=(const Polynomial<T>& other) {
-    if (p.size() < other.p.size())
-        p.resize(other.p.size());
-    for (size_t i = 0; i < std::min(p.size(), other.p.size()); ++i)
-        p[i] -= other.p[i];
+    HSE_SCOPED_OP("polynomial_dense.subtract");
+    HSE_COUNT_FLOPS("polynomial_dense.subtract", other.p.read().size());
+    Cow<ArrayBuffer<T>> keep = other.p;
+    const ArrayBuffer<T>& o = keep.read();
+    std::vector<T>& v = storage();
+    if (v.size() < o.size())
+        v.resize(o.size());
+    for (size_t i = 0; i < o.size(); ++i)
+        v[i] -= o[i];
     cut();
     return *this;
 }
 
 template<typename T>
 Polynomial<T>& Polynomial<T>::operator*=(const Polynomial<T>& other) {
-    size_t new_size = p.size() * other.p.size();
-    std::vector<T> res(new_size, T());
-    for (size_t i = 0; i < p.size(); ++i)
-        for (size_t j = 0; j < other.p.size(); ++j)
-            res[i + j] += p[i] * other.p[j];
-    p = res;
+    const ArrayBuffer<T>& a = p.read();
+    const ArrayBuffer<T>& b = other.p.read();
+    HSE_SCOPED_OP("polynomial_dense.multiply");
+    HSE_COUNT_FLOPS("polynomial_dense.multiply", 2 * a.size() * b.size());
+    std::vector<T> res(a.empty() || b.empty() ? 0 : a.size() + b.size() - 1, T());
+    HSE_COUNT_ALLOC("polynomial_dense.alloc", res.size() * sizeof(T));
+    Convolve(res.data(), a.data(), a.size(), b.data(), b.size());
+    p = ArrayBuffer<T>(std::move(res));
     cut();
     return *this;
 }
 
 template<typename T>
-Polynomial<T> Polynomial<T>::operator+(const Polynomial<T>& r) const {
+Polynomial<T> Polynomial<T>::operator+(const Polynomial<T>& r) const& {
     Polynomial<T> res = *this;
     res += r;
     return res;
 }
 
 template<typename T>
-Polynomial<T> Polynomial<T>::operator-(const Polynomial<T>& r) const {
+Polynomial<T> Polynomial<T>::operator+(const Polynomial<T>& r) && {
+    *this += r;
+    return std::move(*this);
+}
+
+template<typename T>
+Polynomial<T> Polynomial<T>::operator+(Polynomial<T>&& r) const& {
+    r += *this;
+    return std::move(r);
+}
+
+template<typename T>
+Polynomial<T> Polynomial<T>::operator+(Polynomial<T>&& r) && {
+    *this += r;
+    return std::move(*this);
+}
+
+template<typename T>
+Polynomial<T> Polynomial<T>::operator-(const Polynomial<T>& r) const& {
     Polynomial<T> res = *this;
     res -= r;
     return res;
 }
 
 template<typename T>
-Polynomial<T> Polynomial<T>::operator*(const Polynomial<T>& r) const {
+Polynomial<T> Polynomial<T>::operator-(const Polynomial<T>& r) && {
+    *this -= r;
+    return std::move(*this);
+}
+
+template<typename T>
+Polynomial<T> Polynomial<T>::operator*(const Polynomial<T>& r) const& {
     Polynomial<T> res = *this;
     res *= r;
     return res;
 }
 
+template<typename T>
+Polynomial<T> Polynomial<T>::operator*(const Polynomial<T>& r) && {
+    *this *= r;
+    return std::move(*this);
+}
+
 template<typename T>
 Polynomial<T> Polynomial<T>::operator&(const Polynomial<T>& r) const {
+    HSE_SCOPED_OP("polynomial_dense.compose");
+    const ArrayBuffer<T>& v = p.read();
     Polynomial<T> res(T(0));
     Polynomial<T> cur(T(1));
-    for (size_t i = 0; i < p.size(); ++i) {
-        res += cur * p[i];
+    for (size_t i = 0; i < v.size(); ++i) {
+        res += cur * v[i];
         cur *= r;
     }
     return res;
@@ -157,6 +269,7 @@ Polynomial<T> Polynomial<T>::operator&(const Polynomial<T>& r) const {
 
 template<typename T>
 Polynomial<T> Polynomial<T>::operator/(const Polynomial<T>& r) const {
+    HSE_SCOPED_OP("polynomial_dense.divide");
     Polynomial<T> res = T(), cur = *this, other = r;
     while (cur.Degree() >= other.Degree()) {
         size_t dif = cur.Degree() - other.Degree();
@@ -171,11 +284,13 @@ Polynomial<T> Polynomial<T>::operator/(const Polynomial<T>& r) const {
 
 template<typename T>
 Polynomial<T> Polynomial<T>::operator%(const Polynomial<T>& r) const {
+    HSE_SCOPED_OP("polynomial_dense.remainder");
     return *this - ((*this / r) * r);
 }
 
 template<typename T>
 Polynomial<T> Polynomial<T>::operator,(const Polynomial<T>& r) const {
+    HSE_SCOPED_OP("polynomial_dense.gcd");
     Polynomial<T> cur = *this, other = r;
     while (other != T(0)) {
         cur = cur % other;
@@ -186,14 +301,181 @@ Polynomial<T> Polynomial<T>::operator,(const Polynomial<T>& r) const {
 
 template<typename T>
 T Polynomial<T>::operator()(T v) const {
-    if (p.empty())
+    const ArrayBuffer<T>& c = p.read();
+    if (c.empty())
         return T();
-    T cur = T(1), res = T();
-    for (size_t i = 0; i < p.size(); ++i) {
-        res += cur * p[i];
-        cur *= v;
+    HSE_SCOPED_OP("polynomial_dense.evaluate");
+    HSE_COUNT_FLOPS("polynomial_dense.evaluate", 2 * c.size());
+    return EvaluatePolynomial(c.data(), c.size(), v);
+}
+
+template<typename T>
+bool Polynomial<T>::miller_inverses(size_t len, const T& h0, std::vector<T>& inv) {
+    inv.assign(len, T());
+    T prod = T(1);
+    for (size_t k = 1; k < len; ++k) {
+        if (T(k) == T())
+            return false;
+        inv[k] = prod;
+        prod *= T(k) * h0;
     }
-    return res;
+    T rest = T(1) / prod;
+    for (size_t k = len; k-- > 1;) {
+        T v = inv[k] * rest;
+        rest *= T(k) * h0;
+        inv[k] = v;
+    }
+    return true;
+}
+
+// In-place radix-2 FFT; a.size() must be a power of two.
+template<typename F>
+void Fft(std::vector<std::complex<F>>& a, bool invert) {
+    size_t n = a.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(a[i], a[j]);
+    }
+    const F pi = std::acos(F(-1));
+    std::vector<std::complex<F>> w;
+    for (size_t len = 2; len <= n; len <<= 1) {
+        size_t half = len / 2;
+        w.resize(half);
+        for (size_t k = 0; k < half; ++k)
+            w[k] = std::polar(F(1), (invert ? 2 : -2) * pi * F(k) / F(len));
+        for (size_t i = 0; i < n; i += len)
+            for (size_t k = 0; k < half; ++k) {
+                std::complex<F> u = a[i + k], v = a[i + k + half] * w[k];
+                a[i + k] = u + v;
+                a[i + k + half] = u - v;
+            }
+    }
+    if (invert)
+        for (size_t i = 0; i < n; ++i)
+            a[i] /= F(n);
+}
+
+// Writing *this = x^s h with h(0) != 0, only h^n is computed; how depends on T.
+//
+// Types declared fields by FieldTraits (e.g. ModInt with a prime modulus),
+// for n >= 8: the J.C.P. Miller recurrence. With g = h^n, the identity h g' = n h' g gives every
+// coefficient from the previous d = deg h ones:
+//   k h[0] g[k] = sum over 1 <= i <= min(k, d) of ((n + 1) i - k) h[i] g[k - i],
+// O(n d^2) against O((n d)^2) for repeated squaring. It is exact in a field
+// but divides by k up to n d, so if some such k is zero in T (small
+// characteristic) this falls back to squaring.
+//
+// Everything else uses repeated squaring: built-in integers because the
+// recurrence's intermediate sums would overflow well before the result does,
+// floating point because it loses every coefficient much smaller than the
+// largest one (see pow_fft for a faster but lossy alternative), other types
+// because without exact division it gives wrong results.
+template<typename T>
+Polynomial<T> Polynomial<T>::pow(size_t n) const {
+    HSE_SCOPED_OP("polynomial_dense.pow");
+    const ArrayBuffer<T>& f = p.read();
+    if (n == 0)
+        return Polynomial<T>(T(1));
+    if (f.empty() || n == 1)
+        return *this;
+    size_t s = 0;
+    while (f[s] == T())
+        ++s;
+    const T* h = f.data() + s;
+    size_t d = f.size() - 1 - s, len = n * d + 1;
+
+    auto squaring = [this, n]() {
+        Polynomial<T> res(T(1)), cur = *this;
+        for (size_t e = n; e; e >>= 1) {
+            if (e & 1)
+                res *= cur;
+            if (e > 1)
+                cur *= cur;
+        }
+        return res;
+    };
+
+    if constexpr (std::is_arithmetic<T>::value) {
+        return squaring();
+    } else {
+        if (n < 8 || !FieldTraits<T>::is_field())
+            return squaring();
+        std::vector<T> g(n * s + len, T());
+        T* out = g.data() + n * s;
+        HSE_COUNT_FLOPS("polynomial_dense.pow", 4 * len * d);
+        out[0] = T(1);
+        T a = h[0];
+        for (size_t e = n; e; e >>= 1) {
+            if (e & 1)
+                out[0] *= a;
+            a *= a;
+        }
+        std::vector<T> inv;
+        if (!miller_inverses(len, h[0], inv))
+            return squaring();
+        for (size_t k = 1; k < len; ++k) {
+            T sum = T();
+            for (size_t i = 1; i <= std::min(k, d); ++i)
+                sum += (T((n + 1) * i) - T(k)) * h[i] * out[k - i];
+            out[k] = sum * inv[k];
+        }
+        return Polynomial<T>(std::move(g));
+    }
+}
+
+// Floating-point power in the FFT domain, for when speed matters more than
+// accuracy: with *this = x^s h, h is transformed once at a size m >= n d + 1,
+// every point is raised to the n-th power and one inverse transform gives
+// h^n, O(n d log(n d)) against O((n d)^2) for pow.
+//
+// It is lossy. Every point value is bounded by S^n, S the sum of |h[i]|, and
+// raising it to the n-th power multiplies its rounding error by about n, so
+// each coefficient comes back with an absolute error of roughly
+// (n + log2 m) eps S^n. For h with nonnegative coefficients S^n is the sum of
+// the result's coefficients, so everything much smaller than the largest
+// coefficient is noise, possibly of the wrong sign: (1 + x)^600 gives
+// constant and linear terms of order 1e164.
+template<typename T>
+Polynomial<T> Polynomial<T>::pow_fft(size_t n) const {
+    static_assert(std::is_floating_point<T>::value, "pow_fft needs floating-point coefficients");
+    HSE_SCOPED_OP("polynomial_dense.pow_fft");
+    const ArrayBuffer<T>& f = p.read();
+    if (n == 0)
+        return Polynomial<T>(T(1));
+    if (f.empty() || n == 1)
+        return *this;
+    size_t s = 0;
+    while (f[s] == T())
+        ++s;
+    const T* h = f.data() + s;
+    size_t d = f.size() - 1 - s, len = n * d + 1;
+    std::vector<T> g(n * s + len, T());
+    T* out = g.data() + n * s;
+    size_t m = 1;
+    while (m < len)
+        m <<= 1;
+    HSE_COUNT_FLOPS("polynomial_dense.pow_fft", 10 * m * (1 + std::log2(m)));
+    std::vector<std::complex<T>> a(m);
+    for (size_t i = 0; i <= d; ++i)
+        a[i] = h[i];
+    Fft(a, false);
+    for (size_t i = 0; i < m; ++i) {
+        std::complex<T> r = T(1), b = a[i];
+        for (size_t e = n; e; e >>= 1) {
+            if (e & 1)
+                r *= b;
+            b *= b;
+        }
+        a[i] = r;
+    }
+    Fft(a, true);
+    for (size_t k = 0; k < len; ++k)
+        out[k] = a[k].real();
+    return Polynomial<T>(std::move(g));
 }
 
 template<typename T>
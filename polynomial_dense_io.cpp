@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "polynomial_dense.cpp"
+#include "serialization.cpp"
+
+template<typename T>
+void WritePolynomial(std::ostream& out, const Polynomial<T>& p) {
+    size_t n = p.Degree() + 1;
+    WriteHeader(out, MakeHeader<T>(BinaryKind::DensePolynomial, n, 1, n * sizeof(T)));
+    WriteArray(out, p.begin(), n);
+}
+
+template<typename T>
+Polynomial<T> ReadPolynomial(std::istream& in) {
+    BinaryHeader h = ReadHeader<T>(in, BinaryKind::DensePolynomial);
+    return Polynomial<T>(ArrayBuffer<T>(ReadArray<T>(in, h.rows)));
+}
+
+// Coefficients are read straight from the mapping until the polynomial is
+// first modified.
+template<typename T>
+Polynomial<T> MapPolynomial(const std::string& path) {
+    IntrusivePtr<MappedFile> file(new MappedFile(path));
+    const BinaryHeader& h = file->header<T>(BinaryKind::DensePolynomial);
+    return Polynomial<T>(file->array<T>(h.payload, h.rows));
+}
+
+// Reads one polynomial in the text form written by operator<<.
+template<typename T>
+Polynomial<T> ParsePolynomial(std::istream& in) {
+    std::string text;
+    if (!(in >> text))
+        throw std::runtime_error("no polynomial to read");
+    std::vector<std::pair<size_t, T>> terms = ParsePolynomialTerms<T>(text);
+    size_t n = 0;
+    for (size_t i = 0; i < terms.size(); ++i)
+        n = std::max(n, terms[i].first + 1);
+    std::vector<T> v(n, T());
+    for (size_t i = 0; i < terms.size(); ++i)
+        v[terms[i].first] += terms[i].second;
+    return Polynomial<T>(std::move(v));
+}
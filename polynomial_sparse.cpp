@@ -1,23 +1,48 @@
+#pragma once
+
 #include <iostream>
 #include <vector>
 #include <utility>
 #include <algorithm>
 #include <map>
+#include <numeric>
+
+#include "cow.cpp"
+#include "field.cpp"
+#include "instrumentation.cpp"
 
 template<typename T>
 class Polynomial {
 private:
-    std::map<size_t, T> p;
+    Cow<std::map<size_t, T>> p;
 
     T get(size_t i) const {
-        return (p.find(i) == p.end() ? T() : p.at(i));
+        const std::map<size_t, T>& m = p.read();
+        auto it = m.find(i);
+        return (it == m.end() ? T() : it->second);
+    }
+
+    // Unshares the terms before a write; this is where copies of a
+    // Polynomial actually allocate.
+    std::map<size_t, T>& terms() {
+#ifdef HSE_INSTRUMENT
+        if (p.shared())
+            HSE_COUNT_ALLOC("polynomial_sparse.copy", p.read().size() * sizeof(std::pair<const size_t, T>));
+#endif
+        return p.write();
     }
 
     void set(size_t i, const T& v) {
-        if (v == T() && p.find(i) != p.end())
-            p.erase(i);
-        else if (v != T())
-            p[i] = v;
+        if (v == T()) {
+            if (p.read().count(i))
+                terms().erase(i);
+        } else {
+#ifdef HSE_INSTRUMENT
+            if (!p.read().count(i))
+                HSE_COUNT_ALLOC("polynomial_sparse.alloc", sizeof(std::pair<const size_t, T>));
+#endif
+            terms()[i] = v;
+        }
     }
 
     static T b_pow(T a, size_t b) {
@@ -33,18 +58,13 @@ private:
         return res;
     }
 
-    Polynomial<T> pow(size_t b) const {
-        Polynomial<T> res = T(1), cur = *this;
-        while (true) {
-            if (b & 1)
-                res *= cur;
-            b >>= 1;
-            if (!b)
-                break;
-            cur *= cur;
-        }
-        return res;
-    }
+    using Terms = std::vector<std::pair<size_t, T>>;
+
+    static Terms multiply_terms(const Terms& a, const Terms& h);
+
+    // 1 / (k h0) for 1 <= k < len with a single division (prefix products
+    // walked back), or false if some k is zero in T.
+    static bool miller_inverses(size_t len, const T& h0, std::vector<T>& inv);
 
 public:
     Polynomial() { }
@@ -58,6 +78,12 @@ public:
         set(0, k);
     }
 
+    explicit Polynomial(std::map<size_t, T> terms) {
+        for (auto it = terms.begin(); it != terms.end();)
+            it = (it->second == T() ? terms.erase(it) : std::next(it));
+        p = std::move(terms);
+    }
+
     template<typename Iter>
     Polynomial(Iter begin, Iter end) {
         for (size_t i = 0; begin != end; ++begin, ++i)
@@ -65,11 +91,11 @@ public:
     }
 
     typename std::map<size_t, T>::const_iterator begin() const {
-        return p.cbegin();
+        return p.read().cbegin();
     }
 
     typename std::map<size_t, T>::const_iterator end() const {
-        return p.cend();
+        return p.read().cend();
     }
 
     int Degree() const;
@@ -86,11 +112,21 @@ public:
 
     Polynomial& operator*=(const Polynomial& other);
 
-    Polynomial operator+(const Polynomial& other) const;
+    Polynomial operator+(const Polynomial& other) const&;
+
+    Polynomial operator+(const Polynomial& other) &&;
+
+    Polynomial operator+(Polynomial&& other) const&;
+
+    Polynomial operator+(Polynomial&& other) &&;
 
-    Polynomial operator-(const Polynomial& other) const;
+    Polynomial operator-(const Polynomial& other) const&;
 
-    Polynomial operator*(const Polynomial& other) const;
+    Polynomial operator-(const Polynomial& other) &&;
+
+    Polynomial operator*(const Polynomial& other) const&;
+
+    Polynomial operator*(const Polynomial& other) &&;
 
     Polynomial operator&(const Polynomial& other) const;
 
@@ -101,15 +137,16 @@ public:
     Polynomial operator,(const Polynomial& other) const;
 
     T operator()(T v) const;
+
+    Polynomial pow(size_t n) const;
 };
 
 template<typename T>
 int Polynomial<T>::Degree() const {
-    if (p.begin() == p.end())
+    const std::map<size_t, T>& m = p.read();
+    if (m.empty())
         return -1;
-    auto it = p.end();
-    --it;
-    return it->first;
+    return m.rbegin()->first;
 }
 
 template<typename T>
@@ -119,8 +156,9 @@ T Polynomial<T>::operator[](size_t i) const {
 
 template<typename T>
 bool Polynomial<T>::operator==(const Polynomial<T>& other) const {
-    return (Degree() == other.Degree()) &&
-           (std::equal(std::begin(p), std::end(p), std::begin(other.p)));
+    const std::map<size_t, T>& a = p.read();
+    const std::map<size_t, T>& b = other.p.read();
+    return (a.size() == b.size()) && (std::equal(std::begin(a), std::end(a), std::begin(b)));
 }
 
 template<typename T>
@@ -128,63 +166,105 @@ bool Polynomial<T>::operator!=(const Polynomial<T>& other) const {
     return !(*this == other);
  }
 
+// Holding another reference to other's storage costs a refcount increment,
+// and makes set() detach first when other is *this.
 template<typename T>
 Polynomial<T>& Polynomial<T>::operator+=(const Polynomial<T>& other) {
-    Polynomial<T> tmp = other;
-    for (auto it = tmp.p.begin(); it != tmp.p.end(); ++it)
+    HSE_SCOPED_OP("polynomial_sparse.add");
+    HSE_COUNT_FLOPS("polynomial_sparse.add", other.p.read().size());
+    Cow<std::map<size_t, T>> keep = other.p;
+    for (auto it = keep.read().begin(); it != keep.read().end(); ++it)
         set(it->first, get(it->first) + it->second);
     return *this;
 }
 
 template<typename T>
 Polynomial<T>& Polynomial<T>::operator-=(const Polynomial<T>& other) {
-    Polynomial<T> tmp = other;
-    for (auto it = tmp.p.begin(); it != tmp.p.end(); ++it)
+    HSE_SCOPED_OP("polynomial_sparse.subtract");
+    HSE_COUNT_FLOPS("polynomial_sparse.subtract", other.p.read().size());
+    Cow<std::map<size_t, T>> keep = other.p;
+    for (auto it = keep.read().begin(); it != keep.read().end(); ++it)
         set(it->first, get(it->first) - it->second);
     return *this;
 }
 
 template<typename T>
 Polynomial<T>& Polynomial<T>::operator*=(const Polynomial<T>& other) {
-    Polynomial<T> tmp = other, copy = *this;
-    p.clear();
-    for (auto it1 = copy.p.begin(); it1 != copy.p.end(); ++it1)
-        for (auto it2 = tmp.p.begin(); it2 != tmp.p.end(); ++it2)
+    HSE_SCOPED_OP("polynomial_sparse.multiply");
+    Cow<std::map<size_t, T>> keep = other.p, copy = std::move(p);
+    const std::map<size_t, T>& a = copy.read();
+    const std::map<size_t, T>& b = keep.read();
+    HSE_COUNT_FLOPS("polynomial_sparse.multiply", 2 * a.size() * b.size());
+    p = Cow<std::map<size_t, T>>();
+    for (auto it1 = a.begin(); it1 != a.end(); ++it1)
+        for (auto it2 = b.begin(); it2 != b.end(); ++it2)
             set(it1->first + it2->first, get(it1->first + it2->first) + it1->second * it2->second);
     return *this;
 }
 
 template<typename T>
-Polynomial<T> Polynomial<T>::operator+(const Polynomial<T>& r) const {
+Polynomial<T> Polynomial<T>::operator+(const Polynomial<T>& r) const& {
     Polynomial<T> res = *this;
     res += r;
     return res;
 }
 
 template<typename T>
-Polynomial<T> Polynomial<T>::operator-(const Polynomial<T>& r) const {
+Polynomial<T> Polynomial<T>::operator+(const Polynomial<T>& r) && {
+    *this += r;
+    return std::move(*this);
+}
+
+template<typename T>
+Polynomial<T> Polynomial<T>::operator+(Polynomial<T>&& r) const& {
+    r += *this;
+    return std::move(r);
+}
+
+template<typename T>
+Polynomial<T> Polynomial<T>::operator+(Polynomial<T>&& r) && {
+    *this += r;
+    return std::move(*this);
+}
+
+template<typename T>
+Polynomial<T> Polynomial<T>::operator-(const Polynomial<T>& r) const& {
     Polynomial<T> res = *this;
     res -= r;
     return res;
 }
 
 template<typename T>
-Polynomial<T> Polynomial<T>::operator*(const Polynomial<T>& r) const {
+Polynomial<T> Polynomial<T>::operator-(const Polynomial<T>& r) && {
+    *this -= r;
+    return std::move(*this);
+}
+
+template<typename T>
+Polynomial<T> Polynomial<T>::operator*(const Polynomial<T>& r) const& {
     Polynomial<T> res = *this;
     res *= r;
     return res;
 }
 
+template<typename T>
+Polynomial<T> Polynomial<T>::operator*(const Polynomial<T>& r) && {
+    *this *= r;
+    return std::move(*this);
+}
+
 template<typename T>
 Polynomial<T> Polynomial<T>::operator&(const Polynomial<T>& r) const {
+    HSE_SCOPED_OP("polynomial_sparse.compose");
     Polynomial<T> res = T();
-    for (auto it = p.begin(); it != p.end(); ++it)
+    for (auto it = begin(); it != end(); ++it)
         res += r.pow(it->first) * it->second;
     return res;
 }
 
 template<typename T>
 Polynomial<T> Polynomial<T>::operator/(const Polynomial<T>& r) const {
+    HSE_SCOPED_OP("polynomial_sparse.divide");
     Polynomial<T> res = T(), cur = *this, other = r;
     while (cur.Degree() >= other.Degree()) {
         size_t dif = cur.Degree() - other.Degree();
@@ -198,11 +278,13 @@ Polynomial<T> Polynomial<T>::operator/(const Polynomial<T>& r) const {
 
 template<typename T>
 Polynomial<T> Polynomial<T>::operator%(const Polynomial<T>& r) const {
+    HSE_SCOPED_OP("polynomial_sparse.remainder");
     return *this - ((*this / r) * r);
 }
 
 template<typename T>
 Polynomial<T> Polynomial<T>::operator,(const Polynomial<T>& r) const {
+    HSE_SCOPED_OP("polynomial_sparse.gcd");
     Polynomial<T> cur = *this, other = r;
     while (other != T(0)) {
         cur = cur % other;
@@ -213,8 +295,9 @@ Polynomial<T> Polynomial<T>::operator,(const Polynomial<T>& r) const {
 
 template<typename T>
 T Polynomial<T>::operator()(T v) const {
+    HSE_SCOPED_OP("polynomial_sparse.evaluate");
     T res = T();
-    for (auto it = p.begin(); it != p.end(); ++it)
+    for (auto it = begin(); it != end(); ++it)
         res += it->second * b_pow(v, it->first);
     return res;
 }
@@ -260,4 +343,142 @@ std::ostream& operator<<(std::ostream& out, const Polynomial<T>& p) {
         }
     }
     return out;
-}
\ No newline at end of file
+}
+
+template<typename T>
+bool Polynomial<T>::miller_inverses(size_t len, const T& h0, std::vector<T>& inv) {
+    inv.assign(len, T());
+    T prod = T(1);
+    for (size_t k = 1; k < len; ++k) {
+        if (T(k) == T())
+            return false;
+        inv[k] = prod;
+        prod *= T(k) * h0;
+    }
+    T rest = T(1) / prod;
+    for (size_t k = len; k-- > 1;) {
+        T v = inv[k] * rest;
+        rest *= T(k) * h0;
+        inv[k] = v;
+    }
+    return true;
+}
+
+// a * h for a short h: the |h| shifted and scaled copies of a are merged one
+// after another in exponent order, so each step is linear in the result.
+template<typename T>
+typename Polynomial<T>::Terms Polynomial<T>::multiply_terms(const Terms& a, const Terms& h) {
+    Terms acc, next;
+    for (size_t j = 0; j < h.size(); ++j) {
+        next.clear();
+        next.reserve(acc.size() + a.size());
+        size_t x = 0, y = 0;
+        while (x < acc.size() || y < a.size()) {
+            size_t ey = y < a.size() ? a[y].first + h[j].first : 0;
+            if (y == a.size() || (x < acc.size() && acc[x].first < ey)) {
+                next.push_back(acc[x++]);
+            } else if (x == acc.size() || ey < acc[x].first) {
+                T v = a[y++].second * h[j].second;
+                if (v != T())
+                    next.emplace_back(ey, v);
+            } else {
+                T v = acc[x++].second + a[y++].second * h[j].second;
+                if (v != T())
+                    next.emplace_back(ey, v);
+            }
+        }
+        acc.swap(next);
+    }
+    return acc;
+}
+
+// Sparse-specific powering. The exponents are normalized first: with s the
+// lowest one and g the gcd of the others' distances from it,
+// *this = x^s h(x^g), and only h^n is computed, h having span D = (deg - s) / g.
+// That makes e.g. (1 + x^1000)^n as cheap as (1 + x)^n.
+//
+// A single term is just c^n x^(s n). For types declared fields by FieldTraits
+// (e.g. ModInt with a prime modulus) h^n comes from the J.C.P. Miller
+// recurrence of the dense pow run over the terms of h only, O(t n D) for t
+// terms, when that beats repeated multiplication; the estimate of the latter
+// bounds the size of h^k by both k D + 1 and the number of monomials of degree
+// k in t variables. Otherwise, including every type where the recurrence
+// would lose precision, overflow or divide inexactly, h^n is built by
+// repeated multiplication by h, which on sparse inputs is cheaper than
+// squaring: the last squaring alone costs the square of the result's term
+// count.
+template<typename T>
+Polynomial<T> Polynomial<T>::pow(size_t n) const {
+    HSE_SCOPED_OP("polynomial_sparse.pow");
+    const std::map<size_t, T>& m = p.read();
+    if (n == 0)
+        return Polynomial<T>(T(1));
+    if (m.empty() || n == 1)
+        return *this;
+    size_t s = m.begin()->first, g = 0;
+    if (m.size() == 1) {
+        Polynomial<T> result;
+        T c = b_pow(m.begin()->second, n);
+        if (c != T())
+            result.terms().emplace(s * n, c);
+        return result;
+    }
+    for (auto it = m.begin(); it != m.end(); ++it)
+        g = std::gcd(g, it->first - s);
+    if (g == 0)
+        g = 1;
+    Terms h;
+    h.reserve(m.size());
+    for (auto it = m.begin(); it != m.end(); ++it)
+        h.emplace_back((it->first - s) / g, it->second);
+    size_t t = h.size(), span = h.back().first;
+
+    Terms res;
+    bool done = false;
+    if (FieldTraits<T>::is_field()) {
+        double len = double(n) * double(span) + 1, rmul = 0, monomials = 1;
+        if (len <= double(1 << 24))
+            for (size_t k = 1; k < n && rmul < double(t) * len; ++k) {
+                monomials = monomials * double(k + t - 1) / double(k);
+                rmul += double(t) * std::min(double(k) * double(span) + 1, monomials);
+            }
+        if (len <= double(1 << 24) && double(t) * len <= rmul) {
+            size_t count = n * span + 1;
+            HSE_COUNT_FLOPS("polynomial_sparse.pow", 4 * t * count);
+            std::vector<T> out(count, T());
+            out[0] = T(1);
+            T a = h[0].second;
+            for (size_t e = n; e; e >>= 1) {
+                if (e & 1)
+                    out[0] *= a;
+                a *= a;
+            }
+            std::vector<T> inv;
+            done = miller_inverses(count, h[0].second, inv);
+            for (size_t k = 1; done && k < count; ++k) {
+                T sum = T();
+                for (size_t j = 1; j < t && h[j].first <= k; ++j)
+                    sum += (T((n + 1) * h[j].first) - T(k)) * h[j].second * out[k - h[j].first];
+                out[k] = sum * inv[k];
+            }
+            if (done)
+                for (size_t k = 0; k < count; ++k)
+                    if (out[k] != T())
+                        res.emplace_back(k, out[k]);
+        }
+    }
+    if (!done) {
+        res = h;
+        for (size_t k = 1; k < n; ++k) {
+            HSE_COUNT_FLOPS("polynomial_sparse.pow", 2 * t * res.size());
+            res = multiply_terms(res, h);
+        }
+    }
+
+    std::map<size_t, T> terms;
+    for (size_t k = 0; k < res.size(); ++k)
+        terms.emplace_hint(terms.end(), s * n + res[k].first * g, res[k].second);
+    Polynomial<T> result;
+    result.p = std::move(terms);
+    return result;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "polynomial_sparse.cpp"
+#include "serialization.cpp"
+
+template<typename T>
+void WritePolynomial(std::ostream& out, const Polynomial<T>& p) {
+    std::vector<uint64_t> exps;
+    std::vector<T> coefs;
+    for (auto it = p.begin(); it != p.end(); ++it) {
+        exps.push_back(it->first);
+        coefs.push_back(it->second);
+    }
+    size_t n = exps.size();
+    size_t bytes = AlignedSize(n * sizeof(uint64_t)) + n * sizeof(T);
+    WriteHeader(out, MakeHeader<T>(BinaryKind::SparsePolynomial, n, 1, bytes));
+    WriteArray(out, exps.data(), n);
+    WriteArray(out, coefs.data(), n);
+}
+
+// Builds the term map from the stored arrays, which must hold strictly
+// increasing exponents and nonzero coefficients as WritePolynomial leaves them.
+template<typename T>
+Polynomial<T> PolynomialFromArrays(const uint64_t* exps, const T* coefs, size_t n) {
+    std::map<size_t, T> terms;
+    for (size_t i = 0; i < n; ++i) {
+        if (i && exps[i] <= exps[i - 1])
+            throw std::runtime_error("exponents are not strictly increasing");
+        if (coefs[i] == T())
+            throw std::runtime_error("zero coefficient stored");
+        terms.emplace_hint(terms.end(), exps[i], coefs[i]);
+    }
+    return Polynomial<T>(std::move(terms));
+}
+
+template<typename T>
+Polynomial<T> ReadPolynomial(std::istream& in) {
+    BinaryHeader h = ReadHeader<T>(in, BinaryKind::SparsePolynomial);
+    std::vector<uint64_t> exps = ReadArray<uint64_t>(in, h.rows);
+    std::vector<T> coefs = ReadArray<T>(in, h.rows);
+    return PolynomialFromArrays(exps.data(), coefs.data(), h.rows);
+}
+
+// The map-backed polynomial cannot borrow the mapping, so terms are built
+// from the mapped arrays in one pass without intermediate copies.
+template<typename T>
+Polynomial<T> MapPolynomial(const std::string& path) {
+    IntrusivePtr<MappedFile> file(new MappedFile(path));
+    const BinaryHeader& h = file->header<T>(BinaryKind::SparsePolynomial);
+    const uint64_t* exps = reinterpret_cast<const uint64_t*>(file->data() + h.payload);
+    const T* coefs = reinterpret_cast<const T*>(file->data() + h.payload + AlignedSize(h.rows * sizeof(uint64_t)));
+    return PolynomialFromArrays(exps, coefs, h.rows);
+}
+
+// Reads one polynomial in the text form written by operator<<.
+template<typename T>
+Polynomial<T> ParsePolynomial(std::istream& in) {
+    std::string text;
+    if (!(in >> text))
+        throw std::runtime_error("no polynomial to read");
+    std::vector<std::pair<size_t, T>> terms = ParsePolynomialTerms<T>(text);
+    std::map<size_t, T> m;
+    for (size_t i = 0; i < terms.size(); ++i)
+        m[terms[i].first] += terms[i].second;
+    return Polynomial<T>(std::move(m));
+}
@@ -0,0 +1,105 @@
+#include <cstddef>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// Retire list for deferred destruction. In background mode a worker thread
+// drains the list; otherwise it is drained by flush() at points the owner
+// chooses (e.g. between requests). The list is bounded: once capacity items
+// are pending, retire() destroys the object on the calling thread instead.
+class Reclaimer {
+private:
+    struct Item {
+        void* p;
+        void (*fn)(void*);
+    };
+
+    std::vector<Item> pending;
+    size_t capacity;
+    size_t in_progress;
+    bool stop;
+    std::mutex m;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    std::thread worker;
+
+    static void run(std::vector<Item>& batch) {
+        for (size_t i = 0; i < batch.size(); ++i)
+            batch[i].fn(batch[i].p);
+        batch.clear();
+    }
+
+    void loop() {
+        std::vector<Item> batch;
+        std::unique_lock<std::mutex> lock(m);
+        while (true) {
+            wake.wait(lock, [this] { return stop || !pending.empty(); });
+            if (pending.empty())
+                break;
+            batch.swap(pending);
+            in_progress = batch.size();
+            lock.unlock();
+            run(batch);
+            lock.lock();
+            in_progress = 0;
+            drained.notify_all();
+        }
+    }
+
+public:
+    explicit Reclaimer(size_t cap = 4096, bool background = true)
+        : capacity(cap), in_progress(0), stop(false) {
+        pending.reserve(cap);
+        if (background)
+            worker = std::thread(&Reclaimer::loop, this);
+    }
+
+    Reclaimer(const Reclaimer&) = delete;
+    Reclaimer& operator=(const Reclaimer&) = delete;
+
+    ~Reclaimer() {
+        if (worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(m);
+                stop = true;
+            }
+            wake.notify_one();
+            worker.join();
+        }
+        run(pending);
+    }
+
+    void retire(void* p, void (*fn)(void*)) {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            if (pending.size() < capacity) {
+                pending.push_back({p, fn});
+                if (pending.size() == 1)
+                    wake.notify_one();
+                return;
+            }
+        }
+        fn(p);
+    }
+
+    // Blocks until everything retired so far has been destroyed.
+    void flush() {
+        std::unique_lock<std::mutex> lock(m);
+        if (worker.joinable()) {
+            wake.notify_one();
+            drained.wait(lock, [this] { return pending.empty() && !in_progress; });
+        } else {
+            std::vector<Item> batch;
+            batch.swap(pending);
+            pending.reserve(capacity);
+            lock.unlock();
+            run(batch);
+        }
+    }
+
+    size_t pending_count() {
+        std::lock_guard<std::mutex> lock(m);
+        return pending.size() + in_progress;
+    }
+};
@@ -0,0 +1,311 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <charconv>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cow.cpp"
+
+// Binary layout shared by Matrix and both Polynomial classes: a 64-byte header
+// followed by payload arrays, each starting at a multiple of BinaryAlignment
+// so a mapped file can be used in place.
+//
+//   matrix             rows x cols elements, row-major
+//   dense polynomial   rows coefficients, lowest degree first, cols == 1
+//   sparse polynomial  rows uint64 exponents, then rows coefficients
+const uint32_t BinaryVersion = 1;
+const uint32_t BinaryEndianMark = 0x01020304;
+const size_t BinaryAlignment = 64;
+
+enum class BinaryKind : uint32_t {
+    Matrix = 1,
+    DensePolynomial = 2,
+    SparsePolynomial = 3
+};
+
+class BinaryHeader {
+public:
+    char magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint32_t kind;
+    uint32_t type;
+    uint32_t elem_size;
+    uint32_t reserved;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t payload;
+    uint64_t bytes;
+};
+
+static_assert(sizeof(BinaryHeader) == 64, "BinaryHeader must stay 64 bytes");
+
+// Element type tags written to the header; 0 means some other trivially
+// copyable type, recognized only by its size.
+template<typename T>
+class BinaryType {
+public:
+    static const uint32_t code = 0;
+};
+
+template<> class BinaryType<int32_t> { public: static const uint32_t code = 1; };
+template<> class BinaryType<int64_t> { public: static const uint32_t code = 2; };
+template<> class BinaryType<uint32_t> { public: static const uint32_t code = 3; };
+template<> class BinaryType<uint64_t> { public: static const uint32_t code = 4; };
+template<> class BinaryType<float> { public: static const uint32_t code = 5; };
+template<> class BinaryType<double> { public: static const uint32_t code = 6; };
+template<> class BinaryType<long double> { public: static const uint32_t code = 7; };
+
+inline size_t AlignedSize(size_t n) {
+    return (n + BinaryAlignment - 1) / BinaryAlignment * BinaryAlignment;
+}
+
+template<typename T>
+BinaryHeader MakeHeader(BinaryKind kind, uint64_t rows, uint64_t cols, uint64_t bytes) {
+    static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable elements can be stored");
+    BinaryHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, "HSECPPB", 8);
+    h.version = BinaryVersion;
+    h.endian = BinaryEndianMark;
+    h.kind = static_cast<uint32_t>(kind);
+    h.type = BinaryType<T>::code;
+    h.elem_size = sizeof(T);
+    h.rows = rows;
+    h.cols = cols;
+    h.payload = AlignedSize(sizeof(BinaryHeader));
+    h.bytes = bytes;
+    return h;
+}
+
+// a * b, or false if it does not fit in 64 bits.
+inline bool CheckedMultiply(uint64_t a, uint64_t b, uint64_t& res) {
+    if (a != 0 && b > UINT64_MAX / a)
+        return false;
+    res = a * b;
+    return true;
+}
+
+// Payload size implied by the dimensions of a header, or false if the
+// dimensions are impossible for the kind or the size overflows.
+template<typename T>
+bool ExpectedPayload(const BinaryHeader& h, BinaryKind kind, uint64_t& bytes) {
+    if (kind == BinaryKind::Matrix) {
+        uint64_t n;
+        return CheckedMultiply(h.rows, h.cols, n) && CheckedMultiply(n, sizeof(T), bytes);
+    }
+    if (h.cols != 1)
+        return false;
+    if (kind == BinaryKind::DensePolynomial)
+        return CheckedMultiply(h.rows, sizeof(T), bytes);
+    uint64_t exps, coefs;
+    if (!CheckedMultiply(h.rows, sizeof(uint64_t), exps) || !CheckedMultiply(h.rows, sizeof(T), coefs))
+        return false;
+    if (exps > UINT64_MAX - BinaryAlignment)
+        return false;
+    exps = AlignedSize(exps);
+    if (coefs > UINT64_MAX - exps)
+        return false;
+    bytes = exps + coefs;
+    return true;
+}
+
+template<typename T>
+void CheckHeader(const BinaryHeader& h, BinaryKind kind) {
+    if (std::memcmp(h.magic, "HSECPPB", 8) != 0)
+        throw std::runtime_error("not a binary matrix/polynomial file");
+    if (h.endian != BinaryEndianMark)
+        throw std::runtime_error("file was written with a different byte order");
+    if (h.version != BinaryVersion)
+        throw std::runtime_error("unsupported binary format version");
+    if (h.kind != static_cast<uint32_t>(kind))
+        throw std::runtime_error("file holds a different kind of object");
+    if (h.type != BinaryType<T>::code || h.elem_size != sizeof(T))
+        throw std::runtime_error("file holds a different element type");
+    uint64_t bytes;
+    if (!ExpectedPayload<T>(h, kind, bytes) || h.bytes != bytes)
+        throw std::runtime_error("payload size does not match the dimensions");
+    if (h.payload < sizeof(BinaryHeader) || h.payload % BinaryAlignment != 0)
+        throw std::runtime_error("misplaced payload");
+}
+
+inline void WritePadding(std::ostream& out, size_t written) {
+    static const char zeros[BinaryAlignment] = { };
+    out.write(zeros, AlignedSize(written) - written);
+}
+
+inline void ReadPadding(std::istream& in, size_t read) {
+    in.ignore(AlignedSize(read) - read);
+}
+
+inline void WriteHeader(std::ostream& out, const BinaryHeader& h) {
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    WritePadding(out, sizeof(h));
+}
+
+template<typename T>
+BinaryHeader ReadHeader(std::istream& in, BinaryKind kind) {
+    BinaryHeader h;
+    if (!in.read(reinterpret_cast<char*>(&h), sizeof(h)))
+        throw std::runtime_error("truncated header");
+    CheckHeader<T>(h, kind);
+    in.ignore(h.payload - sizeof(h));
+    return h;
+}
+
+template<typename T>
+void WriteArray(std::ostream& out, const T* data, size_t n) {
+    out.write(reinterpret_cast<const char*>(data), n * sizeof(T));
+    WritePadding(out, n * sizeof(T));
+}
+
+template<typename T>
+std::vector<T> ReadArray(std::istream& in, size_t n) {
+    std::vector<T> v(n);
+    if (!in.read(reinterpret_cast<char*>(v.data()), n * sizeof(T)))
+        throw std::runtime_error("truncated payload");
+    ReadPadding(in, n * sizeof(T));
+    return v;
+}
+
+// Read-only private mapping of a whole file, unmapped with its last reference.
+class MappedFile : public ExternalOwner {
+private:
+    void* addr;
+    size_t len;
+
+public:
+    explicit MappedFile(const std::string& path) : addr(MAP_FAILED), len(0) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("cannot open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            len = static_cast<size_t>(st.st_size);
+            addr = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (addr == MAP_FAILED)
+            throw std::runtime_error("cannot map " + path);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        ::munmap(addr, len);
+    }
+
+    const char* data() const {
+        return static_cast<const char*>(addr);
+    }
+
+    size_t size() const {
+        return len;
+    }
+
+    template<typename T>
+    const BinaryHeader& header(BinaryKind kind) const {
+        if (len < sizeof(BinaryHeader))
+            throw std::runtime_error("truncated header");
+        const BinaryHeader& h = *reinterpret_cast<const BinaryHeader*>(data());
+        CheckHeader<T>(h, kind);
+        if (h.payload > len || h.bytes > len - h.payload)
+            throw std::runtime_error("truncated payload");
+        return h;
+    }
+
+    // n elements starting at byte offset from the beginning of the file.
+    template<typename T>
+    ArrayBuffer<T> array(size_t offset, size_t n) {
+        return ArrayBuffer<T>::Borrow(reinterpret_cast<const T*>(data() + offset), n, this);
+    }
+};
+
+// Reads one value of T at s, advancing s past it.
+template<typename T>
+std::enable_if_t<std::is_arithmetic<T>::value, T> ParseValue(const char*& s, const char* end) {
+    T v = T();
+    std::from_chars_result r = std::from_chars(s, end, v);
+    if (r.ec != std::errc())
+        throw std::runtime_error("malformed number");
+    s = r.ptr;
+    return v;
+}
+
+// End of the value starting at s: the next separator used by the text
+// formats ('*', '+', whitespace) or a '-' that cannot be part of the value,
+// i.e. one not leading it and not following 'e', 'E', '(' or ','.
+inline const char* ValueEnd(const char* s, const char* end) {
+    for (const char* t = s; t != end; ++t) {
+        char c = *t;
+        if (c == '*' || c == '+' || std::isspace(static_cast<unsigned char>(c)))
+            return t;
+        if (c == '-' && t != s && std::strchr("eE(,", t[-1]) == nullptr)
+            return t;
+    }
+    return end;
+}
+
+// Streams only the current value, so parsing stays linear in the input.
+template<typename T>
+std::enable_if_t<!std::is_arithmetic<T>::value, T> ParseValue(const char*& s, const char* end) {
+    end = ValueEnd(s, end);
+    std::istringstream in(std::string(s, end));
+    T v;
+    if (!(in >> v))
+        throw std::runtime_error("malformed value");
+    s += (in.eof() ? end - s : static_cast<std::ptrdiff_t>(in.tellg()));
+    return v;
+}
+
+// Splits the text produced by Polynomial's operator<< ("3*x^2-x+1") into
+// (exponent, coefficient) terms.
+template<typename T>
+std::vector<std::pair<size_t, T>> ParsePolynomialTerms(const std::string& text) {
+    std::vector<std::pair<size_t, T>> terms;
+    const char* s = text.data();
+    const char* end = s + text.size();
+    while (s != end && std::isspace(static_cast<unsigned char>(*s)))
+        ++s;
+    while (s != end && !std::isspace(static_cast<unsigned char>(*s))) {
+        if (*s == '+')
+            ++s;
+        T coef = T(1);
+        if (s != end && *s == '-' && s + 1 != end && s[1] == 'x') {
+            coef = T(-1);
+            ++s;
+        } else if (s != end && *s != 'x') {
+            coef = ParseValue<T>(s, end);
+            if (s == end || *s != '*') {
+                terms.emplace_back(0, coef);
+                continue;
+            }
+            ++s;
+        }
+        if (s == end || *s != 'x')
+            throw std::runtime_error("malformed polynomial");
+        ++s;
+        size_t exp = 1;
+        if (s != end && *s == '^') {
+            ++s;
+            exp = ParseValue<size_t>(s, end);
+        }
+        terms.emplace_back(exp, coef);
+    }
+    return terms;
+}
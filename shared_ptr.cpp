@@ -1,20 +1,30 @@
 #include <cstddef>
 #include <algorithm>
+#include <utility>
+#include <new>
+
+#include "instrumentation.cpp"
 
 template<typename T>
 class Control {
 public:
     T* ptr;
     size_t ref_cnt;
+    void (*release)(Control*);
+
+    static void delete_release(Control* c) {
+        delete c->ptr;
+        delete c;
+    }
 
-    Control(T* p) : ptr(p), ref_cnt(1) { }
+    Control(T* p) : ptr(p), ref_cnt(1), release(&delete_release) { }
+
+    Control(T* p, void (*r)(Control*)) : ptr(p), ref_cnt(1), release(r) { }
 
     void dec() {
         --ref_cnt;
-        if (!ref_cnt) {
-            delete ptr;
-            ptr = nullptr;
-        }
+        if (!ref_cnt)
+            release(this);
     }
 
     void inc() {
@@ -37,21 +47,36 @@ private:
 
     void dec() {
         if (ctrl != nullptr) {
-            ctrl->dec();
-            if (!ctrl->ref_cnt) {
-                delete ctrl;
-                ctrl = nullptr;
-                ptr = nullptr;
-            }
+            Control<T>* c = ctrl;
+            ctrl = nullptr;
+            ptr = nullptr;
+            c->dec();
         }
     }
 
+    // Tag for adopting a ready control block; a plain Control<T>* overload
+    // would make SharedPtr(nullptr) ambiguous.
+    class FromControl { };
+
+    SharedPtr(FromControl, Control<T>* c) noexcept : ptr(c->ptr), ctrl(c) { }
+
+    static Control<T>* make_control(T* p) {
+        HSE_COUNT_ALLOC("shared_ptr.control_block", sizeof(Control<T>));
+        return new Control<T>(p);
+    }
+
+    template<typename U, typename Alloc, typename... Args>
+    friend SharedPtr<U> AllocateShared(Alloc& alloc, Args&&... args);
+
+    template<typename U, typename Reclaimer>
+    friend SharedPtr<U> DeferShared(U* p, Reclaimer& r);
+
 public:
     SharedPtr() noexcept : ptr(nullptr), ctrl(nullptr) { }
 
     SharedPtr(T* p) : ptr(p) {
         if (p != nullptr)
-            ctrl = new Control<T>(p);
+            ctrl = make_control(p);
         else
             ctrl = nullptr;
     }
@@ -69,7 +94,7 @@ public:
         dec();
         ptr = p;
         if (p != nullptr)
-            ctrl = new Control<T>(p);
+            ctrl = make_control(p);
         else
             ctrl = nullptr;
         return *this;
@@ -120,7 +145,7 @@ public:
         dec();
         ptr = p;
         if (p != nullptr)
-            ctrl = new Control<T>(p);
+            ctrl = make_control(p);
         else
             ctrl = nullptr;
     }
@@ -139,3 +164,52 @@ public:
     }
 };
 
+// Places both the object and its control block in a monotonic allocator
+// (anything with allocate(size, align), e.g. Arena). The final release only
+// runs destructors; the memory is reclaimed when the allocator is reset.
+template<typename T, typename Alloc, typename... Args>
+SharedPtr<T> AllocateShared(Alloc& alloc, Args&&... args) {
+    T* p = new (alloc.allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    void* c;
+    try {
+        c = alloc.allocate(sizeof(Control<T>), alignof(Control<T>));
+    } catch (...) {
+        p->~T();
+        throw;
+    }
+    HSE_COUNT_ALLOC("shared_ptr.allocate_shared", sizeof(T) + sizeof(Control<T>));
+    return SharedPtr<T>(typename SharedPtr<T>::FromControl(), new (c) Control<T>(p, [](Control<T>* ctrl) {
+        ctrl->ptr->~T();
+        ctrl->~Control<T>();
+    }));
+}
+
+template<typename T, typename Reclaimer>
+class DeferredControl : public Control<T> {
+public:
+    Reclaimer* reclaimer;
+
+    static void destroy(void* p) {
+        DeferredControl* c = static_cast<DeferredControl*>(p);
+        delete c->ptr;
+        delete c;
+    }
+
+    static void retire(Control<T>* c) {
+        DeferredControl* d = static_cast<DeferredControl*>(c);
+        d->reclaimer->retire(d, &destroy);
+    }
+
+    DeferredControl(T* p, Reclaimer* r) : Control<T>(p, &retire), reclaimer(r) { }
+};
+
+// Opt-in deferred destruction: the final release hands the object to the
+// reclaimer (anything with retire(void*, void (*)(void*)), e.g. Reclaimer)
+// instead of running its destructor on the releasing thread.
+template<typename T, typename Reclaimer>
+SharedPtr<T> DeferShared(T* p, Reclaimer& r) {
+    if (p == nullptr)
+        return SharedPtr<T>();
+    HSE_COUNT_ALLOC("shared_ptr.control_block", sizeof(DeferredControl<T, Reclaimer>));
+    return SharedPtr<T>(typename SharedPtr<T>::FromControl(), new DeferredControl<T, Reclaimer>(p, &r));
+}
@@ -1,37 +1,79 @@
 #include <cstddef>
 #include <algorithm>
-#include <tuple>
 #include <memory>
+#include <type_traits>
+#include <utility>
 
-template<typename T, typename Deleter = std::default_delete<T>>
-class UniquePtr {
-private:
-    std::tuple<T*, Deleter> t;
+#include "instrumentation.cpp"
 
+// Stores the deleter as an empty base when possible, so that UniquePtr with a
+// stateless deleter is exactly one pointer wide.
+template<typename Deleter, bool = std::is_empty<Deleter>::value && !std::is_final<Deleter>::value>
+class DeleterHolder : private Deleter {
 public:
-    UniquePtr() noexcept {
-        std::get<0>(t) = nullptr;
+    DeleterHolder() noexcept(std::is_nothrow_default_constructible<Deleter>::value) : Deleter() { }
+
+    DeleterHolder(const Deleter& d) : Deleter(d) { }
+
+    DeleterHolder(Deleter&& d) noexcept(std::is_nothrow_move_constructible<Deleter>::value) : Deleter(std::move(d)) { }
+
+    const Deleter& get_deleter() const noexcept {
+        return *this;
     }
 
-    UniquePtr(T* p) {
-        std::get<0>(t) = p;
+    Deleter& get_deleter() noexcept {
+        return *this;
     }
+};
+
+template<typename Deleter>
+class DeleterHolder<Deleter, false> {
+private:
+    Deleter d;
+
+public:
+    DeleterHolder() noexcept(std::is_nothrow_default_constructible<Deleter>::value) : d() { }
+
+    DeleterHolder(const Deleter& del) : d(del) { }
 
-    UniquePtr(T* p, Deleter d) : t(std::make_tuple(p, d)) { }
+    DeleterHolder(Deleter&& del) noexcept(std::is_nothrow_move_constructible<Deleter>::value) : d(std::move(del)) { }
 
-    UniquePtr(UniquePtr&& other) : UniquePtr() {
-        std::swap(std::get<0>(t), std::get<0>(other.t));
+    const Deleter& get_deleter() const noexcept {
+        return d;
     }
 
-    UniquePtr& operator=(std::nullptr_t) {
-        std::get<1>(t)(std::get<0>(t));
-        std::get<0>(t) = nullptr;
+    Deleter& get_deleter() noexcept {
+        return d;
+    }
+};
+
+template<typename T, typename Deleter = std::default_delete<T>>
+class UniquePtr : private DeleterHolder<Deleter> {
+private:
+    T* ptr;
+
+public:
+    UniquePtr() noexcept(std::is_nothrow_default_constructible<Deleter>::value) : ptr(nullptr) { }
+
+    UniquePtr(T* p) noexcept(std::is_nothrow_default_constructible<Deleter>::value) : ptr(p) { }
+
+    UniquePtr(T* p, const Deleter& d) : DeleterHolder<Deleter>(d), ptr(p) { }
+
+    UniquePtr(T* p, Deleter&& d) noexcept(std::is_nothrow_move_constructible<Deleter>::value) : DeleterHolder<Deleter>(std::move(d)), ptr(p) { }
+
+    UniquePtr(UniquePtr&& other) noexcept(std::is_nothrow_move_constructible<Deleter>::value)
+        : DeleterHolder<Deleter>(std::move(other.get_deleter())), ptr(other.release()) { }
+
+    UniquePtr& operator=(std::nullptr_t) noexcept {
+        reset();
         return *this;
     }
 
-    UniquePtr& operator=(UniquePtr&& other) {
-        if (std::get<0>(t) != std::get<0>(other.t))
-            std::swap(std::get<0>(t), std::get<0>(other.t));
+    UniquePtr& operator=(UniquePtr&& other) noexcept(std::is_nothrow_move_assignable<Deleter>::value) {
+        if (this == &other)
+            return *this;
+        reset(other.release());
+        get_deleter() = std::move(other.get_deleter());
         return *this;
     }
 
@@ -39,53 +81,154 @@ public:
     UniquePtr& operator=(const UniquePtr&) = delete;
 
     ~UniquePtr() noexcept {
-        std::get<1>(t)(std::get<0>(t));
+        if (ptr != nullptr)
+            get_deleter()(ptr);
     }
 
-    const Deleter& get_deleter() const {
-        return std::get<1>(t);
-    }
-
-    Deleter& get_deleter() {
-        return std::get<1>(t);
-    }
+    using DeleterHolder<Deleter>::get_deleter;
 
     const T& operator*() const {
-        return *std::get<0>(t);
+        return *ptr;
     }
 
     T& operator*() {
-        return *std::get<0>(t);
+        return *ptr;
     }
 
-    T* operator->() {
-        return std::get<0>(t);
+    T* operator->() noexcept {
+        return ptr;
     }
 
-    const T* operator->() const {
-        return std::get<0>(t);
+    const T* operator->() const noexcept {
+        return ptr;
     }
 
-    T* release() {
-        T* ret = std::get<0>(t);
-        std::get<0>(t) = nullptr;
+    T* release() noexcept {
+        T* ret = ptr;
+        ptr = nullptr;
         return ret;
     }
 
-    void reset(T* p) {
-        std::get<1>(t)(std::get<0>(t));
-        std::get<0>(t) = p;
+    void reset(T* p = nullptr) noexcept {
+        T* old = ptr;
+        ptr = p;
+        if (old != nullptr)
+            get_deleter()(old);
     }
 
-    void swap(UniquePtr& other) noexcept {
-        std::swap(std::get<0>(t), std::get<0>(other.t));
+    void swap(UniquePtr& other) noexcept(std::is_nothrow_swappable<Deleter>::value) {
+        std::swap(ptr, other.ptr);
+        std::swap(get_deleter(), other.get_deleter());
     }
 
-    T* get() const {
-        return std::get<0>(t);
+    T* get() const noexcept {
+        return ptr;
     }
 
     explicit operator bool() const noexcept {
-        return std::get<0>(t) != nullptr;
+        return ptr != nullptr;
+    }
+};
+
+template<typename T, typename Deleter>
+class UniquePtr<T[], Deleter> : private DeleterHolder<Deleter> {
+private:
+    T* ptr;
+
+public:
+    UniquePtr() noexcept(std::is_nothrow_default_constructible<Deleter>::value) : ptr(nullptr) { }
+
+    UniquePtr(T* p) noexcept(std::is_nothrow_default_constructible<Deleter>::value) : ptr(p) { }
+
+    UniquePtr(T* p, const Deleter& d) : DeleterHolder<Deleter>(d), ptr(p) { }
+
+    UniquePtr(T* p, Deleter&& d) noexcept(std::is_nothrow_move_constructible<Deleter>::value) : DeleterHolder<Deleter>(std::move(d)), ptr(p) { }
+
+    UniquePtr(UniquePtr&& other) noexcept(std::is_nothrow_move_constructible<Deleter>::value)
+        : DeleterHolder<Deleter>(std::move(other.get_deleter())), ptr(other.release()) { }
+
+    UniquePtr& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    UniquePtr& operator=(UniquePtr&& other) noexcept(std::is_nothrow_move_assignable<Deleter>::value) {
+        if (this == &other)
+            return *this;
+        reset(other.release());
+        get_deleter() = std::move(other.get_deleter());
+        return *this;
+    }
+
+    UniquePtr(const UniquePtr&) = delete;
+    UniquePtr& operator=(const UniquePtr&) = delete;
+
+    ~UniquePtr() noexcept {
+        if (ptr != nullptr)
+            get_deleter()(ptr);
     }
-};
\ No newline at end of file
+
+    using DeleterHolder<Deleter>::get_deleter;
+
+    const T& operator[](size_t i) const {
+        return ptr[i];
+    }
+
+    T& operator[](size_t i) {
+        return ptr[i];
+    }
+
+    T* release() noexcept {
+        T* ret = ptr;
+        ptr = nullptr;
+        return ret;
+    }
+
+    void reset(T* p = nullptr) noexcept {
+        T* old = ptr;
+        ptr = p;
+        if (old != nullptr)
+            get_deleter()(old);
+    }
+
+    void swap(UniquePtr& other) noexcept(std::is_nothrow_swappable<Deleter>::value) {
+        std::swap(ptr, other.ptr);
+        std::swap(get_deleter(), other.get_deleter());
+    }
+
+    T* get() const noexcept {
+        return ptr;
+    }
+
+    explicit operator bool() const noexcept {
+        return ptr != nullptr;
+    }
+};
+
+template<typename T, typename... Args>
+std::enable_if_t<!std::is_array<T>::value, UniquePtr<T>> MakeUnique(Args&&... args) {
+    HSE_COUNT_ALLOC("unique_ptr.make", sizeof(T));
+    return UniquePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+template<typename T>
+std::enable_if_t<std::is_array<T>::value && std::extent<T>::value == 0, UniquePtr<T>>
+MakeUnique(size_t n) {
+    HSE_COUNT_ALLOC("unique_ptr.make", n * sizeof(std::remove_extent_t<T>));
+    return UniquePtr<T>(new std::remove_extent_t<T>[n]());
+}
+
+// Same as MakeUnique, but default-initializes instead of value-initializing,
+// which leaves trivial types (e.g. large numeric buffers) uninitialized.
+template<typename T>
+std::enable_if_t<!std::is_array<T>::value, UniquePtr<T>> MakeUniqueForOverwrite() {
+    HSE_COUNT_ALLOC("unique_ptr.make", sizeof(T));
+    return UniquePtr<T>(new T);
+}
+
+template<typename T>
+std::enable_if_t<std::is_array<T>::value && std::extent<T>::value == 0, UniquePtr<T>>
+MakeUniqueForOverwrite(size_t n) {
+    HSE_COUNT_ALLOC("unique_ptr.make", n * sizeof(std::remove_extent_t<T>));
+    return UniquePtr<T>(new std::remove_extent_t<T>[n]);
+}